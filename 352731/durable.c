@@ -0,0 +1,544 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "durable.h"
+#include "macros.h"
+
+#define DATA_MAGIC 0x3137333235335444ul   // Data file magic number
+#define LOG_MAGIC 0x3137333235334c44ul    // Redo log magic number
+#define RECORD_MAGIC 0x52454344u          // Redo record magic number
+#define DATA_HEADER_SIZE 4096             // Bytes reserved for the data file header
+#define LOG_HEADER_SIZE 64                // Bytes reserved for the redo log header
+#define SEG_HEADER_SIZE 16                // Bytes reserved before each segment
+
+// Data file header, at the start of the mapping
+typedef struct durable_header{
+    uint64_t magic;
+    uint64_t base;      // Address the data file is mapped at
+    uint64_t capacity;  // Size of the data file (in bytes)
+    uint64_t align;     // Alignment of the region
+    uint64_t size;      // Size of the first segment (in bytes)
+    uint64_t bump;      // Offset of the end of the last allocated segment
+} durable_header;
+
+// Segment header, right before the segment's words
+typedef struct durable_segment{
+    uint64_t size;
+    uint64_t live;      // Whether the allocating transaction committed
+} durable_segment;
+
+// Redo record: one committed write set, or one allocation
+typedef struct record_header{
+    uint32_t magic;
+    uint32_t count;     // Number of entries
+    uint64_t len;       // Bytes of entries following the header
+    uint64_t checksum;  // Checksum of the entries
+} record_header;
+
+// Redo record entry, followed by its payload padded to 8 bytes
+typedef struct entry_header{
+    uint64_t offset;    // Destination, relative to the start of the mapping
+    uint64_t size;
+} entry_header;
+
+static uint64_t align_up(uint64_t value, uint64_t align){
+    return (value+align-1)&~(align-1);
+}
+
+static uint64_t seg_align(durable* d){
+    return d->align<SEG_HEADER_SIZE?SEG_HEADER_SIZE:d->align;
+}
+
+static uint64_t checksum(char const* data, size_t len){
+    uint64_t hash=0xcbf29ce484222325ul;
+    for (size_t i=0;i<len;i++){
+        hash=(hash^(unsigned char) data[i])*0x100000001b3ul;
+    }
+    return hash;
+}
+
+static bool write_all(int fd, void const* buf, size_t len, off_t offset){
+    while (len){
+        ssize_t res=pwrite(fd, buf, len, offset);
+        if (unlikely(res<=0)){
+            printf("Durable region: write failed\n");
+            return false;
+        }
+        buf=(char const*) buf+res;
+        len-=res;
+        offset+=res;
+    }
+    return true;
+}
+
+static bool read_all(int fd, void* buf, size_t len, off_t offset){
+    while (len){
+        ssize_t res=pread(fd, buf, len, offset);
+        if (res<=0){
+            return false;
+        }
+        buf=(char*) buf+res;
+        len-=res;
+        offset+=res;
+    }
+    return true;
+}
+
+static size_t buffer_reserve(durable_buffer* b, size_t len){
+    if (b->len+len>b->cap){
+        size_t cap=b->cap?b->cap:4096;
+        while (cap<b->len+len){
+            cap*=2;
+        }
+        b->data=realloc(b->data, cap);
+        b->cap=cap;
+    }
+    size_t at=b->len;
+    b->len+=len;
+    return at;
+}
+
+static size_t record_begin(durable* d){
+    return buffer_reserve(&(d->pending), sizeof(record_header));
+}
+
+static void record_entry(durable* d, uint64_t offset, void const* src, size_t size){
+    size_t at=buffer_reserve(&(d->pending), sizeof(entry_header)+align_up(size, 8));
+    entry_header* entry=(entry_header*) (d->pending.data+at);
+    entry->offset=offset;
+    entry->size=size;
+    memcpy(entry+1, src, size);
+}
+
+static uint64_t record_end(durable* d, size_t at, uint32_t count){
+    record_header* record=(record_header*) (d->pending.data+at);
+    record->magic=RECORD_MAGIC;
+    record->count=count;
+    record->len=d->pending.len-at-sizeof(record_header);
+    record->checksum=checksum((char const*) (record+1), record->len);
+    d->appended+=sizeof(record_header)+record->len;
+    return d->appended;
+}
+
+/** Apply the well-formed records of a redo log, either to the mapping or to the data file.
+ * @return Number of bytes of well-formed records
+**/
+static size_t apply_records(durable* d, char const* data, size_t len, bool to_file){
+    size_t at=0;
+    while (at+sizeof(record_header)<=len){
+        record_header const* record=(record_header const*) (data+at);
+        if (record->magic!=RECORD_MAGIC || at+sizeof(record_header)+record->len>len){
+            break;
+        }
+        char const* entries=(char const*) (record+1);
+        if (checksum(entries, record->len)!=record->checksum){
+            break;
+        }
+        for (uint32_t i=0;i<record->count;i++){
+            entry_header const* entry=(entry_header const*) entries;
+            if (to_file){
+                if (!write_all(d->data_fd, entry+1, entry->size, entry->offset)){
+                    return at;
+                }
+            }else{
+                memcpy(d->base+entry->offset, entry+1, entry->size);
+            }
+            entries+=sizeof(entry_header)+align_up(entry->size, 8);
+        }
+        at+=sizeof(record_header)+record->len;
+    }
+    return at;
+}
+
+/** Apply the redo log to the data file, then truncate it. Must not run concurrently with the flusher.
+ * @return Whether the operation is a success, the redo log being kept otherwise
+**/
+static bool durable_checkpoint(durable* d){
+    size_t len=d->log_end-LOG_HEADER_SIZE;
+    if (len){
+        char* data=malloc(len);
+        if (unlikely(!data || !read_all(d->log_fd, data, len, LOG_HEADER_SIZE))){
+            printf("Durable region: could not read the redo log for checkpointing\n");
+            free(data);
+            return false;
+        }
+        bool applied=apply_records(d, data, len, true)==len;
+        free(data);
+        if (unlikely(!applied)){
+            return false;
+        }
+    }
+    // The data file must be up to date before the log is dropped
+    if (unlikely(fdatasync(d->data_fd)!=0)){
+        return false;
+    }
+    if (len){
+        if (unlikely(ftruncate(d->log_fd, LOG_HEADER_SIZE)!=0 || fdatasync(d->log_fd)!=0)){
+            return false;
+        }
+        d->log_end=LOG_HEADER_SIZE;
+    }
+    d->checkpoint_pending=false;
+    return true;
+}
+
+/** Refuse every further commit, and fail the committers waiting for a sync. Called with log_lock held.
+**/
+static void durable_fail(durable* d, char const* what){
+    if (!atomic_load(&(d->failed))){
+        printf("Durable region: %s failed, no more commits\n", what);
+        atomic_store(&(d->failed), true);
+    }
+    pthread_cond_broadcast(&(d->synced_cond));
+}
+
+/** Flusher thread: write the pending records in groups, one 'fdatasync' per group.
+**/
+static void* durable_flusher(void* arg){
+    durable* d=(durable*) arg;
+    bool recovered=!d->checkpoint_pending || durable_checkpoint(d);
+    pthread_mutex_lock(&(d->log_lock));
+    if (unlikely(!recovered)){
+        durable_fail(d, "the recovery checkpoint");
+    }
+    while (true){
+        while (!d->stop && !(d->waiters && d->pending.len)){
+            pthread_cond_wait(&(d->flush_cond), &(d->log_lock));
+        }
+        if (!d->pending.len){
+            break;
+        }
+        if (d->latency_us>0 && !d->stop && atomic_load(&(d->committing))>(int) d->waiters){
+            // Let the commits still on their way join the group
+            struct timespec pause={d->latency_us/1000000, (d->latency_us%1000000)*1000};
+            pthread_mutex_unlock(&(d->log_lock));
+            nanosleep(&pause, NULL);
+            pthread_mutex_lock(&(d->log_lock));
+        }
+        durable_buffer group=d->pending;
+        d->pending=d->spare;
+        uint64_t target=d->appended;
+        pthread_mutex_unlock(&(d->log_lock));
+
+        bool written=write_all(d->log_fd, group.data, group.len, d->log_end) && fdatasync(d->log_fd)==0;
+        if (likely(written)){
+            d->log_end+=group.len;
+        }else if (ftruncate(d->log_fd, d->log_end)!=0){
+            printf("Durable region: could not drop a torn group from the redo log\n");
+        }
+        group.len=0;
+
+        pthread_mutex_lock(&(d->log_lock));
+        d->spare=group;
+        if (likely(written)){
+            d->synced=target;
+            pthread_cond_broadcast(&(d->synced_cond));
+        }else{
+            durable_fail(d, "writing the redo log");
+        }
+        if (d->log_end-LOG_HEADER_SIZE>=(off_t) DURABLE_CHECKPOINT_BYTES){
+            pthread_mutex_unlock(&(d->log_lock));
+            bool checkpointed=durable_checkpoint(d);
+            pthread_mutex_lock(&(d->log_lock));
+            if (unlikely(!checkpointed)){
+                durable_fail(d, "a checkpoint");
+            }
+        }
+    }
+    pthread_mutex_unlock(&(d->log_lock));
+    return NULL;
+}
+
+/** Create the data file and the redo log of a fresh durable region.
+**/
+static bool durable_format(durable* d, size_t size){
+    { // Empty redo log
+        uint64_t magic=LOG_MAGIC;
+        if (ftruncate(d->log_fd, 0)!=0 || !write_all(d->log_fd, &magic, sizeof(magic), 0)){
+            return false;
+        }
+        d->log_end=LOG_HEADER_SIZE;
+    }
+    if (ftruncate(d->data_fd, 0)!=0 || ftruncate(d->data_fd, d->capacity)!=0){
+        return false;
+    }
+    d->base=mmap(NULL, d->capacity, PROT_READ|PROT_WRITE, MAP_PRIVATE, d->data_fd, 0);
+    if (d->base==MAP_FAILED){
+        return false;
+    }
+    uint64_t first=align_up(DATA_HEADER_SIZE+SEG_HEADER_SIZE, seg_align(d));
+    durable_header header={DATA_MAGIC, (uint64_t) d->base, d->capacity, d->align, size, first+size};
+    durable_segment seg={size, 1};
+    memcpy(d->base, &header, sizeof(header));
+    memcpy(d->base+first-SEG_HEADER_SIZE, &seg, sizeof(seg));
+    if (!write_all(d->data_fd, &header, sizeof(header), 0) || !write_all(d->data_fd, &seg, sizeof(seg), first-SEG_HEADER_SIZE)){
+        return false;
+    }
+    fdatasync(d->data_fd);
+    fdatasync(d->log_fd);
+    return true;
+}
+
+/** Map an existing data file back at its address, and replay its redo log.
+**/
+static bool durable_recover(durable* d, durable_header const* header){
+    void* hint=(void*) header->base;
+#ifdef MAP_FIXED_NOREPLACE
+    d->base=mmap(hint, header->capacity, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED_NOREPLACE, d->data_fd, 0);
+#else
+    d->base=mmap(hint, header->capacity, PROT_READ|PROT_WRITE, MAP_PRIVATE, d->data_fd, 0);
+#endif
+    if (d->base==MAP_FAILED){
+        return false;
+    }
+    if (d->base!=hint){
+        printf("Durable region: cannot map the data file back at %p\n", hint);
+        munmap(d->base, header->capacity);
+        return false;
+    }
+    d->capacity=header->capacity;
+    struct stat st;
+    uint64_t magic=0;
+    if (fstat(d->log_fd, &st)!=0 || st.st_size<LOG_HEADER_SIZE || !read_all(d->log_fd, &magic, sizeof(magic), 0) || magic!=LOG_MAGIC){
+        // No usable redo log: the data file is the last checkpoint
+        magic=LOG_MAGIC;
+        if (ftruncate(d->log_fd, 0)!=0 || !write_all(d->log_fd, &magic, sizeof(magic), 0)){
+            return false;
+        }
+        d->log_end=LOG_HEADER_SIZE;
+        return true;
+    }
+    size_t len=st.st_size-LOG_HEADER_SIZE;
+    char* data=malloc(len?len:1);
+    if (!data || !read_all(d->log_fd, data, len, LOG_HEADER_SIZE)){
+        free(data);
+        return false;
+    }
+    // Replay in memory now, checkpoint in the background; drop any torn tail
+    size_t valid=apply_records(d, data, len, false);
+    free(data);
+    d->log_end=LOG_HEADER_SIZE+valid;
+    if (valid<len){
+        ftruncate(d->log_fd, d->log_end);
+    }
+    d->checkpoint_pending=valid>0;
+    return true;
+}
+
+durable* durable_open(size_t size, size_t align, char const* path, long latency_us, size_t capacity, bool reset){
+    char log_path[4096];
+    durable* d=(durable*) calloc(1, sizeof(durable));
+    if (unlikely(!d)){
+        printf("Could not allocate durable region\n");
+        return NULL;
+    }
+    d->align=align;
+    d->capacity=capacity?capacity:DURABLE_DEFAULT_CAPACITY; // A recovered region keeps the capacity it was created with
+    d->latency_us=latency_us;
+    atomic_init(&(d->failed), false);
+    atomic_init(&(d->committing), 0);
+    atomic_init(&(d->unsynced), 0);
+    snprintf(log_path, sizeof(log_path), "%s.log", path);
+    d->data_fd=open(path, O_RDWR|O_CREAT, 0644);
+    d->log_fd=open(log_path, O_RDWR|O_CREAT, 0644);
+    if (d->data_fd<0 || d->log_fd<0){
+        printf("Durable region: could not open '%s'\n", path);
+        goto fail;
+    }
+    durable_header header;
+    struct stat st;
+    bool fresh=reset || fstat(d->data_fd, &st)!=0 || st.st_size<DATA_HEADER_SIZE
+        || !read_all(d->data_fd, &header, sizeof(header), 0) || header.magic!=DATA_MAGIC;
+    if (fresh){
+        if (size+DATA_HEADER_SIZE+2*seg_align(d)>d->capacity || !durable_format(d, size)){
+            printf("Durable region: could not create '%s'\n", path);
+            goto fail;
+        }
+    }else{
+        if (header.align!=align || header.size!=size){
+            printf("Durable region: '%s' holds a region of another size or alignment\n", path);
+            goto fail;
+        }
+        if (!durable_recover(d, &header)){
+            printf("Durable region: could not recover '%s'\n", path);
+            goto fail;
+        }
+    }
+    pthread_mutex_init(&(d->alloc_lock), NULL);
+    pthread_mutex_init(&(d->log_lock), NULL);
+    pthread_cond_init(&(d->flush_cond), NULL);
+    pthread_cond_init(&(d->synced_cond), NULL);
+    if (pthread_create(&(d->flusher), NULL, durable_flusher, d)!=0){
+        printf("Durable region: could not start the flusher\n");
+        munmap(d->base, d->capacity);
+        goto fail;
+    }
+    return d;
+fail:
+    if (d->data_fd>=0){
+        close(d->data_fd);
+    }
+    if (d->log_fd>=0){
+        close(d->log_fd);
+    }
+    free(d);
+    return NULL;
+}
+
+/** Back a region with a durable file, and rebuild its segment list.
+ * @return Whether the operation is a success
+**/
+bool durable_attach(region* tm_region, size_t size, size_t align, char const* path, long latency_us, size_t capacity, bool reset){
+    durable* d=durable_open(size, align, path, latency_us, capacity, reset);
+    if (!d){
+        return false;
+    }
+    size_t seg_size;
+    word* data=durable_first(d, &seg_size);
+    tm_region->segment_start=make_segment(data, seg_size/align, 0);
+    tm_region->allocs=tm_region->segment_start;
+    if (unlikely(!tm_region->segment_start)){
+        durable_close(d);
+        return false;
+    }
+    while ((data=durable_next(d, data, &seg_size))){
+        segment* seg=make_segment(data, seg_size/align, 0);
+        if (unlikely(!seg)){
+            printf("Could not allocate segment\n");
+            break;
+        }
+        add_segment(tm_region, seg);
+    }
+    tm_region->durable=d;
+    return true;
+}
+
+void durable_close(durable* d){
+    pthread_mutex_lock(&(d->log_lock));
+    d->stop=true;
+    pthread_cond_signal(&(d->flush_cond));
+    pthread_mutex_unlock(&(d->log_lock));
+    pthread_join(d->flusher, NULL);
+    if (!durable_checkpoint(d)){
+        printf("Durable region: could not checkpoint, the redo log is kept\n");
+    }
+    munmap(d->base, d->capacity);
+    close(d->data_fd);
+    close(d->log_fd);
+    pthread_mutex_destroy(&(d->alloc_lock));
+    pthread_mutex_destroy(&(d->log_lock));
+    pthread_cond_destroy(&(d->flush_cond));
+    pthread_cond_destroy(&(d->synced_cond));
+    free(d->pending.data);
+    free(d->spare.data);
+    free(d);
+}
+
+word* durable_first(durable* d, size_t* size){
+    char* data=d->base+align_up(DATA_HEADER_SIZE+SEG_HEADER_SIZE, seg_align(d));
+    *size=((durable_segment*) (data-SEG_HEADER_SIZE))->size;
+    return data;
+}
+
+word* durable_next(durable* d, word* prev, size_t* size){
+    durable_header* header=(durable_header*) d->base;
+    char* data=(char*) prev;
+    while (true){
+        uint64_t end=data-d->base+((durable_segment*) (data-SEG_HEADER_SIZE))->size;
+        uint64_t next=align_up(end+SEG_HEADER_SIZE, seg_align(d));
+        if (next-SEG_HEADER_SIZE>=header->bump){
+            return NULL;
+        }
+        data=d->base+next;
+        // Segments of transactions that did not commit are skipped
+        durable_segment* seg=(durable_segment*) (data-SEG_HEADER_SIZE);
+        if (seg->live){
+            *size=seg->size;
+            return data;
+        }
+    }
+}
+
+word* durable_alloc(durable* d, size_t size){
+    durable_header* header=(durable_header*) d->base;
+    pthread_mutex_lock(&(d->alloc_lock));
+    uint64_t at=align_up(header->bump+SEG_HEADER_SIZE, seg_align(d));
+    if (at+size>d->capacity){
+        pthread_mutex_unlock(&(d->alloc_lock));
+        return NULL;
+    }
+    durable_segment seg={size, 0};
+    memcpy(d->base+at-SEG_HEADER_SIZE, &seg, sizeof(seg));
+    memset(d->base+at, 0, size);
+    header->bump=at+size;
+    // Reserved without waiting, the segment only becomes live with the commit of its transaction
+    pthread_mutex_lock(&(d->log_lock));
+    size_t record=record_begin(d);
+    record_entry(d, at-SEG_HEADER_SIZE, &seg, sizeof(seg));
+    record_entry(d, offsetof(durable_header, bump), &(header->bump), sizeof(header->bump));
+    record_end(d, record, 2);
+    pthread_mutex_unlock(&(d->log_lock));
+    pthread_mutex_unlock(&(d->alloc_lock));
+    return d->base+at;
+}
+
+static uint32_t log_wSet(durable* d, wSet* set){
+    if (!set){
+        return 0;
+    }
+    record_entry(d, (char*) set->dest-d->base, set->src, d->align);
+    return 1+log_wSet(d, set->left)+log_wSet(d, set->right);
+}
+
+static uint32_t log_allocs(durable* d, allocList* allocs){
+    uint32_t count=0;
+    for (;allocs;allocs=allocs->next,count++){
+        char* data=(char*) allocs->data;
+        durable_segment seg={((durable_segment*) (data-SEG_HEADER_SIZE))->size, 1};
+        memcpy(data-SEG_HEADER_SIZE, &seg, sizeof(seg));
+        record_entry(d, data-SEG_HEADER_SIZE-d->base, &seg, sizeof(seg));
+    }
+    return count;
+}
+
+bool durable_commit_begin(durable* d){
+    atomic_fetch_add(&(d->committing), 1);
+    if (unlikely(atomic_load(&(d->failed)))){
+        atomic_fetch_sub(&(d->committing), 1);
+        return false;
+    }
+    return true;
+}
+
+void durable_commit_end(durable* d){
+    atomic_fetch_sub(&(d->committing), 1);
+}
+
+uint64_t durable_log_commit(durable* d, wSet* set, allocList* allocs){
+    pthread_mutex_lock(&(d->log_lock));
+    size_t record=record_begin(d);
+    uint32_t count=log_allocs(d, allocs);
+    uint64_t lsn=record_end(d, record, count+log_wSet(d, set));
+    pthread_mutex_unlock(&(d->log_lock));
+    return lsn;
+}
+
+bool durable_wait(durable* d, uint64_t lsn){
+    pthread_mutex_lock(&(d->log_lock));
+    while (d->synced<lsn && !atomic_load(&(d->failed))){
+        d->waiters++;
+        pthread_cond_signal(&(d->flush_cond));
+        pthread_cond_wait(&(d->synced_cond), &(d->log_lock));
+        d->waiters--;
+    }
+    bool synced=d->synced>=lsn;
+    pthread_mutex_unlock(&(d->log_lock));
+    return synced;
+}
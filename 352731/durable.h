@@ -0,0 +1,66 @@
+#pragma once
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdbool.h>
+
+#include "sets.h"
+
+// Durable regions are created by tm_create_durable, each one with its own data
+// file and redo log "<path>.log".
+//
+// The data file is mapped privately: it is only ever modified by checkpoints,
+// which apply the synced part of the redo log to it. Once a write or a sync of
+// either file fails, the region refuses every further commit.
+
+// Capacity of the data file when the creator leaves it to the library (in bytes)
+#define DURABLE_DEFAULT_CAPACITY (256ul<<20)
+// Size of the redo log beyond which a checkpoint is taken (in bytes)
+#define DURABLE_CHECKPOINT_BYTES (16ul<<20)
+
+// Growable buffer of redo log records
+typedef struct durable_buffer{
+    char* data;
+    size_t len;
+    size_t cap;
+} durable_buffer;
+
+typedef struct durable{
+    int data_fd;            // Data file, written by checkpoints only
+    int log_fd;             // Redo log, written by the flusher only
+    char* base;             // Mapping of the data file
+    size_t capacity;        // Size of the mapping (in bytes)
+    size_t align;           // Alignment of the segments' words
+    pthread_mutex_t alloc_lock; // Serializes segment allocations
+    pthread_mutex_t log_lock;   // Protects every field below
+    pthread_cond_t flush_cond;  // Signaled when a committer waits for its records
+    pthread_cond_t synced_cond; // Broadcast when records have been synced
+    durable_buffer pending;     // Records appended but not written yet
+    durable_buffer spare;       // Buffer being written by the flusher
+    uint64_t appended;      // Bytes of records appended since the region was opened
+    uint64_t synced;        // Bytes of records durably written
+    unsigned int waiters;   // Number of committers waiting for a sync
+    bool stop;              // Whether the flusher must exit
+    off_t log_end;          // End of the redo log file (flusher only)
+    long latency_us;        // Group commit window
+    bool checkpoint_pending; // Replayed records still have to be checkpointed
+    atomic_bool failed;     // Whether a write or a sync failed (set under log_lock)
+    atomic_int committing;  // Commits between durable_commit_begin and durable_commit_end
+    atomic_ulong unsynced;  // Commits made visible whose records could not be synced
+    pthread_t flusher;
+} durable;
+
+durable* durable_open(size_t size, size_t align, char const* path, long latency_us, size_t capacity, bool reset);
+bool durable_attach(region* tm_region, size_t size, size_t align, char const* path, long latency_us, size_t capacity, bool reset);
+void durable_close(durable* d);
+
+word* durable_first(durable* d, size_t* size);
+word* durable_next(durable* d, word* prev, size_t* size);
+word* durable_alloc(durable* d, size_t size);
+
+bool durable_commit_begin(durable* d);
+void durable_commit_end(durable* d);
+uint64_t durable_log_commit(durable* d, wSet* set, allocList* allocs);
+bool durable_wait(durable* d, uint64_t lsn);
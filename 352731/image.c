@@ -0,0 +1,262 @@
+#define _GNU_SOURCE
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "image.h"
+#include "macros.h"
+
+#define IMAGE_MAGIC 0x3137333235334d49ul  // Image file magic number
+
+// Image file header
+typedef struct image_header{
+    uint64_t magic;
+    uint64_t align;
+    uint64_t clock;
+    uint64_t start;         // Original address of the first segment
+    uint64_t nb_segments;
+    uint64_t nb_intervals;
+    uint64_t locks_offset;  // File offset of the lock section
+    uint64_t locks_size;    // Size of the lock section (in bytes)
+} image_header;
+
+// Saved segment, ordered by growing address
+typedef struct image_segment{
+    uint64_t addr;          // Original address of the words
+    uint64_t len;           // Number of words
+    uint64_t interval;      // Interval holding the words
+    uint64_t locks;         // Offset of the lock stamps in the lock section
+} image_segment;
+
+// Range of pages holding one or more segments, mapped in one go
+typedef struct image_interval{
+    uint64_t addr;          // Original page-aligned address
+    uint64_t size;          // Size (in bytes, multiple of the page size)
+    uint64_t offset;        // File offset
+} image_interval;
+
+static uint64_t page_floor(uint64_t value, uint64_t page){
+    return value&~(page-1);
+}
+
+static uint64_t page_ceil(uint64_t value, uint64_t page){
+    return (value+page-1)&~(page-1);
+}
+
+static bool image_write(int fd, void const* buf, size_t len, off_t offset){
+    while (len){
+        ssize_t res=pwrite(fd, buf, len, offset);
+        if (unlikely(res<=0)){
+            return false;
+        }
+        buf=(char const*) buf+res;
+        len-=res;
+        offset+=res;
+    }
+    return true;
+}
+
+static bool image_read(int fd, void* buf, size_t len, off_t offset){
+    while (len){
+        ssize_t res=pread(fd, buf, len, offset);
+        if (res<=0){
+            return false;
+        }
+        buf=(char*) buf+res;
+        len-=res;
+        offset+=res;
+    }
+    return true;
+}
+
+bool save_image(region* tm_region, char const* path){
+    uint64_t page=sysconf(_SC_PAGESIZE);
+    size_t nb_segments=0;
+    for (segment* seg=tm_region->allocs;seg;seg=seg->next){
+        nb_segments++;
+    }
+    image_segment* segs=(image_segment*) calloc(nb_segments, sizeof(image_segment));
+    image_interval* intervals=(image_interval*) calloc(nb_segments, sizeof(image_interval));
+    if (unlikely(!segs || !intervals)){
+        free(segs);
+        free(intervals);
+        return false;
+    }
+    // Group the segments sharing pages, since they must be mapped together
+    image_header header={IMAGE_MAGIC, tm_region->align, atomic_load(&(tm_region->clock)), (uint64_t) tm_region->segment_start->raw_data, nb_segments, 0, 0, 0};
+    size_t i=0;
+    for (segment* seg=tm_region->allocs;seg;seg=seg->next,i++){
+        uint64_t lo=page_floor((uint64_t) seg->raw_data, page);
+        uint64_t hi=page_ceil((uint64_t) seg->raw_data+seg->len*tm_region->align, page);
+        image_interval* last=header.nb_intervals?&(intervals[header.nb_intervals-1]):NULL;
+        if (last && lo<last->addr+last->size){
+            if (hi>last->addr+last->size){
+                last->size=hi-last->addr;
+            }
+        }else{
+            intervals[header.nb_intervals++]=(image_interval){lo, hi-lo, 0};
+        }
+        segs[i]=(image_segment){(uint64_t) seg->raw_data, seg->len, header.nb_intervals-1, header.locks_size};
+        header.locks_size+=seg->len*sizeof(lockStamp);
+    }
+    uint64_t offset=page_ceil(sizeof(header)+nb_segments*sizeof(image_segment)+header.nb_intervals*sizeof(image_interval), page);
+    for (i=0;i<header.nb_intervals;i++){
+        intervals[i].offset=offset;
+        offset+=intervals[i].size;
+    }
+    header.locks_offset=offset;
+
+    bool ok=false;
+    int fd=open(path, O_WRONLY|O_CREAT|O_TRUNC, 0644);
+    if (fd<0 || ftruncate(fd, page_ceil(offset+header.locks_size, page))!=0){
+        goto done;
+    }
+    if (!image_write(fd, &header, sizeof(header), 0)
+        || !image_write(fd, segs, nb_segments*sizeof(image_segment), sizeof(header))
+        || !image_write(fd, intervals, header.nb_intervals*sizeof(image_interval), sizeof(header)+nb_segments*sizeof(image_segment))){
+        goto done;
+    }
+    i=0;
+    for (segment* seg=tm_region->allocs;seg;seg=seg->next,i++){
+        image_interval* interval=&(intervals[segs[i].interval]);
+        // No transaction runs: no lock is held, and the words are stable
+        if (!image_write(fd, seg->raw_data, seg->len*tm_region->align, interval->offset+(segs[i].addr-interval->addr))
+            || !image_write(fd, seg->locks, seg->len*sizeof(lockStamp), header.locks_offset+segs[i].locks)){
+            goto done;
+        }
+    }
+    ok=true;
+done:
+    if (!ok){
+        printf("Could not save region image to '%s'\n", path);
+    }
+    if (fd>=0){
+        close(fd);
+    }
+    free(segs);
+    free(intervals);
+    return ok;
+}
+
+static bool image_track(region* tm_region, void* addr, size_t size){
+    image_map* map=(image_map*) malloc(sizeof(image_map));
+    if (unlikely(!map)){
+        munmap(addr, size);
+        return false;
+    }
+    map->addr=addr;
+    map->size=size;
+    map->next=tm_region->images;
+    tm_region->images=map;
+    return true;
+}
+
+region* load_image(char const* path){
+    image_header header;
+    image_segment* segs=NULL;
+    image_interval* intervals=NULL;
+    region* tm_region=NULL;
+    bool initialized=false;
+    int fd=open(path, O_RDONLY);
+    if (fd<0 || !image_read(fd, &header, sizeof(header), 0) || header.magic!=IMAGE_MAGIC || !header.nb_segments){
+        goto fail;
+    }
+    segs=(image_segment*) malloc(header.nb_segments*sizeof(image_segment));
+    intervals=(image_interval*) malloc(header.nb_intervals*sizeof(image_interval));
+    tm_region=(region*) malloc(sizeof(region));
+    if (tm_region){
+        tm_region->allocs=NULL;
+        tm_region->images=NULL;
+    }
+    if (unlikely(!segs || !intervals || !tm_region)
+        || !image_read(fd, segs, header.nb_segments*sizeof(image_segment), sizeof(header))
+        || !image_read(fd, intervals, header.nb_intervals*sizeof(image_interval), sizeof(header)+header.nb_segments*sizeof(image_segment))){
+        goto fail;
+    }
+    init_region(tm_region, header.align);
+    initialized=true;
+    atomic_store(&(tm_region->clock), header.clock);
+    tm_region->durable=NULL;
+
+    // Map the words back at their original addresses, which the stored pointers refer to
+    for (uint64_t i=0;i<header.nb_intervals;i++){
+#ifdef MAP_FIXED_NOREPLACE
+        void* addr=mmap((void*) intervals[i].addr, intervals[i].size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_FIXED_NOREPLACE, fd, intervals[i].offset);
+#else
+        void* addr=mmap((void*) intervals[i].addr, intervals[i].size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, intervals[i].offset);
+#endif
+        if (addr==MAP_FAILED || addr!=(void*) intervals[i].addr){
+            if (addr!=MAP_FAILED){
+                munmap(addr, intervals[i].size);
+            }
+            printf("Region image: cannot map the words back at %p\n", (void*) intervals[i].addr);
+            goto fail;
+        }
+        if (!image_track(tm_region, addr, intervals[i].size)){
+            goto fail;
+        }
+    }
+    char* locks=mmap(NULL, header.locks_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, header.locks_offset);
+    if (locks==MAP_FAILED || !image_track(tm_region, locks, header.locks_size)){
+        goto fail;
+    }
+
+    // Rebuild the segment list, the first segment first
+    for (uint64_t i=0;i<header.nb_segments;i++){
+        segment* seg=(segment*) malloc(sizeof(segment));
+        if (unlikely(!seg)){
+            goto fail;
+        }
+        seg->len=segs[i].len;
+        seg->raw_data=(word*) segs[i].addr;
+        seg->locks=(lockStamp*) (locks+segs[i].locks);
+        seg->next=NULL;
+        seg->borrowed_data=true;
+        seg->borrowed_locks=true;
+        if (!tm_region->allocs){
+            tm_region->allocs=seg;
+        }else{
+            add_segment(tm_region, seg);
+        }
+        if (segs[i].addr==header.start){
+            tm_region->segment_start=seg;
+        }
+    }
+    close(fd);
+    free(segs);
+    free(intervals);
+    return tm_region;
+fail:
+    printf("Could not load region image from '%s'\n", path);
+    if (tm_region){
+        while (tm_region->allocs){
+            segment* tail=tm_region->allocs->next;
+            free(tm_region->allocs);
+            tm_region->allocs=tail;
+        }
+        unmap_image(tm_region);
+        if (initialized){
+            pthread_mutex_destroy(&(tm_region->trick_lock));
+            pthread_rwlock_destroy(&(tm_region->serial_lock));
+        }
+        free(tm_region);
+    }
+    if (fd>=0){
+        close(fd);
+    }
+    free(segs);
+    free(intervals);
+    return NULL;
+}
+
+void unmap_image(region* tm_region){
+    while (tm_region->images){
+        image_map* tail=tm_region->images->next;
+        munmap(tm_region->images->addr, tm_region->images->size);
+        free(tm_region->images);
+        tm_region->images=tail;
+    }
+}
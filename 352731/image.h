@@ -0,0 +1,23 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "sets.h"
+
+// Region images: a quiescent snapshot of the segments, their words and their
+// lock versions. Loading maps the image privately, so pages are faulted in
+// lazily. Segments are mapped back at their original addresses, so that the
+// pointers stored in shared memory stay valid: loading fails if any of these
+// addresses is taken in the loading process.
+
+// One mapping of a loaded image
+typedef struct image_map{
+    void* addr;
+    size_t size;
+    struct image_map* next;
+} image_map;
+
+bool save_image(region* tm_region, char const* path);
+region* load_image(char const* path);
+void unmap_image(region* tm_region);
@@ -4,7 +4,7 @@
 #include "macros.h"
 
 bool init_lockstamp(lockStamp* ls, int version){
-    ls->versionStamp=version;
+    atomic_init(&(ls->versionStamp), version);
     atomic_init(&(ls->locked), false);
     return true;
 }
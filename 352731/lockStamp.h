@@ -7,7 +7,7 @@
 #include "tm.h"
 
 typedef struct lockStamp{
-    int versionStamp;
+    atomic_int versionStamp;   // Written under the lock, before its release
     atomic_bool locked;
 }lockStamp;
 
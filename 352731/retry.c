@@ -0,0 +1,79 @@
+#define _GNU_SOURCE
+#include <limits.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "retry.h"
+#include "macros.h"
+
+static uint64_t retry_bit(lockStamp* ls){
+    return 1ull<<(((uintptr_t) ls/sizeof(lockStamp))%RETRY_BUCKETS);
+}
+
+static uint64_t retry_mask(wSet* set){
+    if (!set){
+        return 0;
+    }
+    return retry_bit(set->ls)|retry_mask(set->left)|retry_mask(set->right);
+}
+
+uint64_t retry_wSet_mask(region* tm_region, wSet* set){
+    // Nobody to wake: skip the walk
+    if (likely(!atomic_load(&(tm_region->parked)))){
+        return 0;
+    }
+    return retry_mask(set);
+}
+
+void retry_wake(region* tm_region, uint64_t mask){
+    if (likely(!mask || !atomic_load(&(tm_region->parked)))){
+        return;
+    }
+    for (size_t i=0;i<RETRY_BUCKETS;i++){
+        if ((mask&(1ull<<i)) && atomic_load(&(tm_region->retry_waiters[i]))){
+            atomic_fetch_add(&(tm_region->retry_seq), 1);
+            syscall(SYS_futex, &(tm_region->retry_seq), FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+            return;
+        }
+    }
+}
+
+// Whether a stripe of the read set was written since the snapshot, or is being written
+static bool retry_changed(rSet* set, int rv){
+    for (;set;set=set->next){
+        if (test_lockstamp(set->ls) || set->ls->versionStamp>rv){
+            return true;
+        }
+    }
+    return false;
+}
+
+void retry_park(region* tm_region, rSet* set, int rv){
+    // Without a read set, any commit may be the awaited one
+    uint64_t mask=0;
+    for (rSet* cell=set;cell;cell=cell->next){
+        mask|=retry_bit(cell->ls);
+    }
+    if (!mask){
+        mask=~0ull;
+    }
+    // Register before sampling, so that a commit either sees us or is seen by the check below
+    atomic_fetch_add(&(tm_region->parked), 1);
+    for (size_t i=0;i<RETRY_BUCKETS;i++){
+        if (mask&(1ull<<i)){
+            atomic_fetch_add(&(tm_region->retry_waiters[i]), 1);
+        }
+    }
+    int seq=atomic_load(&(tm_region->retry_seq));
+    while (set?!retry_changed(set, rv):atomic_load(&(tm_region->clock))==rv){
+        syscall(SYS_futex, &(tm_region->retry_seq), FUTEX_WAIT_PRIVATE, seq, NULL, NULL, 0);
+        seq=atomic_load(&(tm_region->retry_seq));
+    }
+    for (size_t i=0;i<RETRY_BUCKETS;i++){
+        if (mask&(1ull<<i)){
+            atomic_fetch_sub(&(tm_region->retry_waiters[i]), 1);
+        }
+    }
+    atomic_fetch_sub(&(tm_region->parked), 1);
+}
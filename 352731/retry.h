@@ -0,0 +1,14 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "sets.h"
+
+// Blocking retry: a transaction calling tm_retry aborts, then its thread sleeps
+// on the region's futex until a commit may have changed what it read. Parked
+// threads register in the buckets of the stripes they read; committers only
+// bump the futex word when they wrote to a bucket with parked threads.
+
+uint64_t retry_wSet_mask(region* tm_region, wSet* set);
+void retry_wake(region* tm_region, uint64_t mask);
+void retry_park(region* tm_region, rSet* set, int rv);
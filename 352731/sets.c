@@ -1,5 +1,21 @@
+#define _GNU_SOURCE
+#include <limits.h>
+#include <linux/futex.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
 #include "sets.h"
 #include "macros.h"
+#include "durable.h"
+#include "retry.h"
+
+// Slot where this thread last published a commit to the combiner
+static _Thread_local unsigned int combine_hint;
+// Next thread token to hand out, and the calling thread's one (0 until its first transaction)
+static atomic_uint next_mode_token=1;
+static _Thread_local unsigned int mode_token=0;
 
 
 void clear_rSet(rSet* set){
@@ -19,6 +35,61 @@ void clear_wSet(wSet* set){
     }
 }
 
+void init_region(region* tm_region, size_t align){
+    tm_region->align       = align;
+    tm_region->free_trick  = NULL;
+    atomic_init(&(tm_region->clock), 0);
+    atomic_init(&(tm_region->irrevocable), false);
+    atomic_init(&(tm_region->mode), MODE_OPTIMISTIC);
+    for (size_t i=0;i<MODE_SLOTS;i++){
+        atomic_init(&(tm_region->optimistic_active[i].active), 0);
+    }
+    atomic_init(&(tm_region->window_attempts), 0);
+    atomic_init(&(tm_region->window_commits), 0);
+    tm_region->serial_commits=0;
+    atomic_init(&(tm_region->serial_begins), 0);
+    atomic_init(&(tm_region->serial_since), 0);
+    atomic_init(&(tm_region->switches_serial), 0);
+    atomic_init(&(tm_region->switches_optimistic), 0);
+    tm_region->images=NULL;
+    atomic_init(&(tm_region->combiner), false);
+    for (size_t i=0;i<COMBINE_SLOTS;i++){
+        atomic_init(&(tm_region->combine_slots[i].request), NULL);
+        atomic_init(&(tm_region->combine_slots[i].status), COMBINE_ABORTED);
+        tm_region->combine_slots[i].lsn=0;
+    }
+    atomic_init(&(tm_region->combine_seq), 0);
+    atomic_init(&(tm_region->combine_sleepers), 0);
+    atomic_init(&(tm_region->parked), 0);
+    for (size_t i=0;i<RETRY_BUCKETS;i++){
+        atomic_init(&(tm_region->retry_waiters[i]), 0);
+    }
+    atomic_init(&(tm_region->retry_seq), 0);
+    pthread_rwlock_init(&(tm_region->serial_lock), NULL);
+    pthread_mutex_init(&(tm_region->trick_lock), NULL);
+}
+
+segment* make_segment(word* raw_data, size_t len, int version){
+    segment* seg=(segment*) malloc(sizeof(segment));
+    if (unlikely(!seg)){
+        return NULL;
+    }
+    seg->locks=(lockStamp*) malloc(sizeof(lockStamp)*len);
+    if (unlikely(!seg->locks)){
+        free(seg);
+        return NULL;
+    }
+    for (size_t i=0;i<len;i++){
+        init_lockstamp(&(seg->locks[i]), version);
+    }
+    seg->len=len;
+    seg->raw_data=raw_data;
+    seg->next=NULL;
+    seg->borrowed_data=true;
+    seg->borrowed_locks=false;
+    return seg;
+}
+
 segment* find_segment(shared_t shared, word* target){
     region* tm_region=(region* ) shared;
     segment* segment=tm_region->allocs;
@@ -53,32 +124,235 @@ void* add_segment(shared_t shared, segment* seg){
 }
 
 
-bool rSet_check(rSet* set, int wv, int rv){
-    if (wv!=rv+1){
-        while (set){
-            rSet* tail=set->next;
-            if (test_lockstamp(set->ls) || set->ls->versionStamp > rv){
-                // if (DEBUG>1){
-                //     printf("Failed rSet check on lock %p, locked: %d, vStamp/rv : %d/%d\n", set->ls, set->ls->locked, set->ls->versionStamp,rv);
-                // }
+void rSet_append(transac* tr, lockStamp* ls, word* addr){
+    rSet* newRCell= (rSet*) malloc(sizeof(rSet));
+    newRCell->ls=ls;
+    newRCell->addr=addr;
+    newRCell->next=tr->rSet;
+    newRCell->bucket_next=NULL;
+    tr->rSet=newRCell;
+}
+
+void rSet_upgrade(transac* tr){
+    memset(tr->rIndex, 0, sizeof(tr->rIndex));
+    rSet** link=&(tr->rSet);
+    while (*link){
+        rSet* cell=*link;
+        rSet** bucket=&(tr->rIndex[((uintptr_t) cell->ls/sizeof(lockStamp))%RSET_BUCKETS]);
+        rSet* dup=*bucket;
+        while (dup && dup->ls!=cell->ls){
+            dup=dup->bucket_next;
+        }
+        if (dup){
+            *link=cell->next;
+            free(cell);
+            continue;
+        }
+        cell->bucket_next=*bucket;
+        *bucket=cell;
+        link=&(cell->next);
+    }
+    tr->upgraded=true;
+}
+
+void rSet_insert(transac* tr, lockStamp* ls, word* addr){
+    rSet** bucket=&(tr->rIndex[((uintptr_t) ls/sizeof(lockStamp))%RSET_BUCKETS]);
+    for (rSet* cell=*bucket;cell;cell=cell->bucket_next){
+        if (cell->ls==ls){
+            return;
+        }
+    }
+    rSet* newRCell= (rSet*) malloc(sizeof(rSet));
+    newRCell->ls=ls;
+    newRCell->addr=addr;
+    newRCell->next=tr->rSet;
+    newRCell->bucket_next=*bucket;
+    tr->rSet=newRCell;
+    *bucket=newRCell;
+}
+
+bool rSet_validate(rSet* set, wSet* own, int rv){
+    while (set){
+        // Lock first: an unlocked stripe then shows the version of its last write-back
+        // A stripe locked by our own commit is still consistent
+        if (test_lockstamp(set->ls) && !(own && wSet_contains(set->addr, own))){
+            return false;
+        }
+        if (atomic_load_explicit(&(set->ls->versionStamp), memory_order_acquire) > rv){
+            return false;
+        }
+        set=set->next;
+    }
+    return true;
+}
+
+bool rSet_extend(region* tm_region, transac* tr){
+    int now=atomic_load(&(tm_region->clock));
+    if (now==tr->rv){
+        return true;
+    }
+    // Every read is still valid at 'now', the snapshot can be moved forward
+    if (!rSet_validate(tr->rSet, NULL, tr->rv)){
+        return false;
+    }
+    tr->rv=now;
+    return true;
+}
+
+bool rSet_check(rSet* set, wSet* own, int wv, int rv){
+    if (wv==rv+1){
+        return true;
+    }
+    return rSet_validate(set, own, rv);
+}
+
+bool commit_allowed(region* reg){
+    // Called after the clock tick: either the irrevocable transaction's clock sample sees the tick,
+    // or this load sees its token (both are sequentially consistent)
+    return !atomic_load(&(reg->irrevocable));
+}
+
+void irrevocable_acquire(region* reg){
+    while (atomic_exchange(&(reg->irrevocable), true)){
+        sched_yield();
+    }
+    // Commits ticking the clock from now on give up: only the ones that already hold their locks may still write
+}
+
+void irrevocable_settle(lockStamp* ls){
+    // A stripe locked past the token is either written by an earlier commit, or released unwritten
+    while (test_lockstamp(ls)){
+        sched_yield();
+    }
+}
+
+void irrevocable_release(region* reg){
+    atomic_store(&(reg->irrevocable), false);
+}
+
+// Indicator of the calling thread, shared by no other thread up to MODE_SLOTS of them
+static atomic_int* mode_slot_own(region* reg){
+    if (unlikely(mode_token==0)){
+        mode_token=atomic_fetch_add_explicit(&next_mode_token, 1, memory_order_relaxed);
+    }
+    return &(reg->optimistic_active[mode_token%MODE_SLOTS].active);
+}
+
+static unsigned long long mode_now(void){
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (unsigned long long) now.tv_sec*1000000000ull+(unsigned long long) now.tv_nsec;
+}
+
+// Switch back to the optimistic mode, with serial_lock held exclusively: no serialized transaction runs
+static void mode_switch_optimistic(region* reg){
+    reg->serial_commits=0;
+    atomic_store(&(reg->window_attempts), 0);
+    atomic_store(&(reg->window_commits), 0);
+    atomic_store(&(reg->mode), MODE_OPTIMISTIC);
+    atomic_fetch_add(&(reg->switches_optimistic), 1);
+}
+
+// Whether the serialized mode used up its budget, so that phases with few read-write commits do not stay serialized
+static bool mode_serial_expired(region* reg){
+    return atomic_fetch_add(&(reg->serial_begins), 1)+1>=SERIAL_BUDGET_BEGINS
+        || mode_now()-atomic_load(&(reg->serial_since))>=SERIAL_BUDGET_NS;
+}
+
+bool mode_enter(region* reg, bool is_ro){
+    while (true){
+        if (likely(atomic_load(&(reg->mode))==MODE_OPTIMISTIC)){
+            atomic_int* active=mode_slot_own(reg);
+            atomic_fetch_add(active, 1);
+            if (likely(atomic_load(&(reg->mode))==MODE_OPTIMISTIC)){
                 return false;
             }
-            free(set);
-            set=tail;
+            atomic_fetch_sub(active, 1);
+        }else{
+            if (is_ro){
+                pthread_rwlock_rdlock(&(reg->serial_lock));
+            }else{
+                pthread_rwlock_wrlock(&(reg->serial_lock));
+            }
+            if (likely(atomic_load(&(reg->mode))==MODE_SERIAL) && unlikely(mode_serial_expired(reg))){
+                // Only an exclusive holder may switch
+                if (is_ro){
+                    pthread_rwlock_unlock(&(reg->serial_lock));
+                    pthread_rwlock_wrlock(&(reg->serial_lock));
+                }
+                if (atomic_load(&(reg->mode))==MODE_SERIAL){
+                    mode_switch_optimistic(reg);
+                }
+            }else if (likely(atomic_load(&(reg->mode))==MODE_SERIAL)){
+                // Let the optimistic transactions begun before the switch finish
+                for (size_t i=0;i<MODE_SLOTS;i++){
+                    while (atomic_load(&(reg->optimistic_active[i].active))){
+                        sched_yield();
+                    }
+                }
+                return true;
+            }
+            pthread_rwlock_unlock(&(reg->serial_lock));
         }
+    }
+}
+
+void mode_leave(region* reg, bool is_serial){
+    if (is_serial){
+        pthread_rwlock_unlock(&(reg->serial_lock));
     }else{
-        clear_rSet(set);
+        atomic_fetch_sub(mode_slot_own(reg), 1);
     }
-    return true;
+}
+
+void mode_sample_attempt(region* reg){
+    if (reg->durable){
+        // Serialized transactions write in place, without redo records
+        return;
+    }
+    int attempts=atomic_fetch_add(&(reg->window_attempts), 1)+1;
+    if (likely(attempts!=ADAPT_WINDOW)){
+        return;
+    }
+    // Last attempt of the window: evaluate it and start a new one
+    int commits=atomic_exchange(&(reg->window_commits), 0);
+    atomic_store(&(reg->window_attempts), 0);
+    if ((attempts-commits)*100 < attempts*ADAPT_ABORT_PERCENT){
+        return;
+    }
+    // The budget starts before the switch, which only this window's last attempt makes
+    atomic_store(&(reg->serial_begins), 0);
+    atomic_store(&(reg->serial_since), mode_now());
+    int expected=MODE_OPTIMISTIC;
+    if (atomic_compare_exchange_strong(&(reg->mode), &expected, MODE_SERIAL)){
+        atomic_fetch_add(&(reg->switches_serial), 1);
+    }
+}
+
+void mode_serial_commit(region* reg){
+    // Called with serial_lock held exclusively: no transaction runs concurrently
+    if (++reg->serial_commits<SERIAL_WINDOW){
+        return;
+    }
+    mode_switch_optimistic(reg);
 }
 
 void abort_tr(region* reg, transac* tr){
     if (unlikely(!tr)){
         return;
     }
+    if (tr->is_irrevocable){
+        irrevocable_release(reg);
+    }
+    mode_leave(reg, tr->is_serial);
     if (tr->wSet){
         tm_prepend_wSet_trick(reg, tr->wSet);
     }
+    while (tr->allocs){
+        allocList* tail=tr->allocs->next;
+        free(tr->allocs);
+        tr->allocs=tail;
+    }
     clear_rSet(tr->rSet);
     free(tr);
 }
@@ -150,10 +424,15 @@ void wSet_release_locks(wSet* root, int wv_to_write){
     if (!root){
         return;
     }
-    if (wv_to_write!=-1){
-        root->ls->versionStamp=wv_to_write;
+    if (root->folded_into){
+        // The lock belongs to another request of the batch
+        root->folded_into=NULL;
+    }else{
+        if (wv_to_write!=-1){
+            atomic_store_explicit(&(root->ls->versionStamp), wv_to_write, memory_order_release);
+        }
+        release_lockstamp(root->ls);
     }
-    release_lockstamp(root->ls);
     wSet_release_locks(root->left,wv_to_write);
     wSet_release_locks(root->right,wv_to_write);
 }
@@ -162,17 +441,250 @@ void wSet_commit_release(region* tm_region, wSet* set, int wv){
     if (!set){
         return;
     }
-    memcpy(set->dest, set->src, tm_region->align);
-    if (wv!=-1){
-        set->ls->versionStamp=wv;
+    // A folded delta is written back by the cell it was folded into
+    if (!set->folded_into){
+        memcpy(set->dest, set->src, tm_region->align);
+        if (wv!=-1){
+            atomic_store_explicit(&(set->ls->versionStamp), wv, memory_order_release);
+        }
+        release_lockstamp(set->ls);
     }
-    release_lockstamp(set->ls);
     wSet_commit_release(tm_region,set->left,wv);
     wSet_commit_release(tm_region,set->right,wv);
     free(set->src);
     free(set);
 }
 
+void wSet_absorb_delta(wSet* cell, void* value){
+    int64_t sum, delta;
+    memcpy(&sum, value, sizeof(int64_t));
+    memcpy(&delta, cell->src, sizeof(int64_t));
+    sum+=delta;
+    memcpy(value, &sum, sizeof(int64_t));
+    memcpy(cell->src, &sum, sizeof(int64_t));
+    cell->is_delta=false;
+}
+
+void wSet_resolve_deltas(wSet* set){
+    if (!set){
+        return;
+    }
+    if (set->is_delta){
+        int64_t value;
+        memcpy(&value, set->dest, sizeof(int64_t));
+        wSet_absorb_delta(set, &value);
+    }
+    wSet_resolve_deltas(set->left);
+    wSet_resolve_deltas(set->right);
+}
+
+bool commit_apply(region* reg, transac* tx, uint64_t* lsn){
+    // An irrevocable transaction has exclusive commit rights
+    if (!commit_allowed(reg)){
+        return false;
+    }
+    // Acquire locks on wSet
+    if (!wSet_acquire_locks(tx->wSet)){
+        return false;
+    }
+    // Sample secondary (write-version) clock
+    tx->wv=atomic_fetch_add(&(reg->clock), 1)+1;
+    // Check the token again, then rSet state
+    if (!commit_allowed(reg) || !rSet_check(tx->rSet, tx->wSet, tx->wv, tx->rv)){
+        wSet_release_locks(tx->wSet, -1);
+        return false;
+    }
+    // The locked words cannot change anymore: deltas become plain values
+    wSet_resolve_deltas(tx->wSet);
+    // Log wSet while its locks are held, so that redo records follow the commit order
+    *lsn=reg->durable?durable_log_commit(reg->durable, tx->wSet, tx->allocs):0;
+    uint64_t wake=retry_wSet_mask(reg, tx->wSet);
+    // Commit wSet, release locks and write clocks
+    wSet_commit_release(reg, tx->wSet, tx->wv);
+    tx->wSet=NULL;
+    retry_wake(reg, wake);
+    return true;
+}
+
+// Whether the transaction read the given stripe (its read set is indexed once it wrote)
+static bool rSet_indexed(transac* tr, lockStamp* ls){
+    for (rSet* cell=tr->rIndex[((uintptr_t) ls/sizeof(lockStamp))%RSET_BUCKETS];cell;cell=cell->bucket_next){
+        if (cell->ls==ls){
+            return true;
+        }
+    }
+    return false;
+}
+
+// Delta cell of a batched request locking the stripe of the given unread delta, NULL if there is none
+static wSet* combine_fold_target(combine_slot** batch, size_t count, transac* tx, wSet* cell, size_t* owner){
+    if (!cell->is_delta || rSet_indexed(tx, cell->ls)){
+        return NULL;
+    }
+    for (size_t i=0;i<count;i++){
+        wSet* held=wSet_contains(cell->dest, atomic_load(&(batch[i]->request))->wSet);
+        if (!held){
+            continue;
+        }
+        if (held->folded_into){
+            return NULL; // Only the request holding the lock may take the deltas
+        }
+        *owner=i;
+        return held->is_delta?held:NULL;
+    }
+    return NULL;
+}
+
+// Release the lock of one cell, or forget the cell its delta was folded into
+static void combine_unlock(wSet* cell){
+    if (cell->folded_into){
+        cell->folded_into=NULL;
+    }else{
+        release_lockstamp(cell->ls);
+    }
+}
+
+// Lock the write set of a request joining the batch, folding its deltas to stripes the batch already holds
+static bool combine_acquire(combine_slot** batch, size_t count, transac* tx, wSet* set, uint64_t* depends){
+    if (!set){
+        return true;
+    }
+    if (!take_lockstamp(set->ls)){
+        size_t owner;
+        set->folded_into=combine_fold_target(batch, count, tx, set, &owner);
+        if (!set->folded_into){
+            return false;
+        }
+        *depends|=1ull<<owner;
+    }
+    if (!combine_acquire(batch, count, tx, set->left, depends)){
+        combine_unlock(set);
+        return false;
+    }
+    if (!combine_acquire(batch, count, tx, set->right, depends)){
+        wSet_release_locks(set->left, -1);
+        combine_unlock(set);
+        return false;
+    }
+    return true;
+}
+
+// Add the folded deltas to the cells they were folded into, which commit them
+static void wSet_fold_deltas(wSet* set){
+    if (!set){
+        return;
+    }
+    if (set->folded_into){
+        int64_t sum, delta;
+        memcpy(&sum, set->folded_into->src, sizeof(int64_t));
+        memcpy(&delta, set->src, sizeof(int64_t));
+        sum+=delta;
+        memcpy(set->folded_into->src, &sum, sizeof(int64_t));
+        set->is_delta=false;
+    }
+    wSet_fold_deltas(set->left);
+    wSet_fold_deltas(set->right);
+}
+
+// Commit every request published so far as one batch: one clock tick and one write-back for all
+static void combine_run(region* reg){
+    combine_slot* batch[COMBINE_SLOTS];
+    uint64_t depends[COMBINE_SLOTS]; // Earlier requests of the batch a request folded deltas into
+    size_t count=0;
+    for (size_t i=0;i<COMBINE_SLOTS;i++){
+        combine_slot* slot=&(reg->combine_slots[i]);
+        // The status goes pending only once the request is published
+        if (atomic_load(&(slot->status))!=COMBINE_PENDING){
+            continue;
+        }
+        // Locked by a regular commit or by a request of this batch: left pending for the next batch,
+        // unless each such stripe is an unread delta of both requests (not in durable regions, whose records are per request)
+        transac* tx=atomic_load(&(slot->request));
+        depends[count]=0;
+        if (reg->durable?!wSet_acquire_locks(tx->wSet):!combine_acquire(batch, count, tx, tx->wSet, &(depends[count]))){
+            continue;
+        }
+        batch[count++]=slot;
+    }
+    if (!count){
+        return;
+    }
+    int wv=atomic_fetch_add(&(reg->clock), 1)+1;
+    bool allowed=commit_allowed(reg);
+    // A request reading a stripe another one writes fails here: the accepted requests commute
+    uint64_t rejected=0;
+    for (size_t i=0;i<count;i++){
+        transac* tx=atomic_load(&(batch[i]->request));
+        // A request whose deltas were folded to a rejected one would have them written by nobody
+        if (!allowed || (depends[i]&rejected) || !rSet_validate(tx->rSet, tx->wSet, tx->rv)){
+            wSet_release_locks(tx->wSet, -1);
+            atomic_store(&(batch[i]->status), COMBINE_ABORTED);
+            batch[i]=NULL;
+            rejected|=1ull<<i;
+            continue;
+        }
+        tx->wv=wv;
+        wSet_fold_deltas(tx->wSet);
+    }
+    // Folding is over: the deltas left are the ones of the cells holding their locks
+    for (size_t i=0;i<count;i++){
+        if (batch[i]){
+            wSet_resolve_deltas(atomic_load(&(batch[i]->request))->wSet);
+        }
+    }
+    uint64_t wake=0;
+    for (size_t i=0;i<count;i++){
+        if (!batch[i]){
+            continue;
+        }
+        transac* tx=atomic_load(&(batch[i]->request));
+        batch[i]->lsn=reg->durable?durable_log_commit(reg->durable, tx->wSet, tx->allocs):0;
+        wake|=retry_wSet_mask(reg, tx->wSet);
+        wSet_commit_release(reg, tx->wSet, wv);
+        tx->wSet=NULL;
+        atomic_store(&(batch[i]->status), COMBINE_COMMITTED);
+    }
+    retry_wake(reg, wake);
+}
+
+bool combine_commit(region* reg, transac* tx, uint64_t* lsn){
+    combine_slot* slot;
+    while (true){
+        slot=&(reg->combine_slots[combine_hint%COMBINE_SLOTS]);
+        transac* expected=NULL;
+        if (atomic_compare_exchange_strong(&(slot->request), &expected, tx)){
+            break;
+        }
+        if (++combine_hint%COMBINE_SLOTS==0){
+            sched_yield();
+        }
+    }
+    atomic_store(&(slot->status), COMBINE_PENDING);
+    // Become the combiner if there is none, otherwise sleep until the current one leaves
+    while (atomic_load(&(slot->status))==COMBINE_PENDING){
+        int seq=atomic_load(&(reg->combine_seq));
+        if (!atomic_load(&(reg->combiner)) && !atomic_exchange(&(reg->combiner), true)){
+            combine_run(reg);
+            atomic_store(&(reg->combiner), false);
+            // Either a sleeper is counted here, or its futex call sees the new sequence number
+            atomic_fetch_add(&(reg->combine_seq), 1);
+            if (atomic_load(&(reg->combine_sleepers))){
+                syscall(SYS_futex, &(reg->combine_seq), FUTEX_WAKE_PRIVATE, INT_MAX, NULL, NULL, 0);
+            }
+            continue;
+        }
+        atomic_fetch_add(&(reg->combine_sleepers), 1);
+        if (atomic_load(&(slot->status))==COMBINE_PENDING){
+            syscall(SYS_futex, &(reg->combine_seq), FUTEX_WAIT_PRIVATE, seq, NULL, NULL, 0);
+        }
+        atomic_fetch_sub(&(reg->combine_sleepers), 1);
+    }
+    bool committed=atomic_load(&(slot->status))==COMBINE_COMMITTED;
+    *lsn=slot->lsn;
+    atomic_store(&(slot->request), NULL);
+    return committed;
+}
+
 void tm_prepend_wSet_trick(region* reg, wSet* set){
     pthread_mutex_lock(&(reg->trick_lock));
     set->free_trick_link=reg->free_trick;
@@ -3,6 +3,7 @@
 #include <pthread.h>
 #include <stdatomic.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <tm.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -22,24 +23,89 @@ typedef struct wSet{
     struct wSet* left;
     struct wSet* right;
     struct wSet* free_trick_link;
-    
+    bool is_delta;      // src holds an int64_t to add to the word at commit, instead of its new value
+    struct wSet* folded_into; // Delta cell of an earlier request of the same combined batch, locking the stripe and applying this delta too
 } wSet;
 
-// Linked lists to track read operations
+// Number of buckets of the read-set index, keyed by stripe (lockStamp) address
+#define RSET_BUCKETS 64
+// Number of logged reads between two incremental validations
+#define VALIDATION_PERIOD 32
+// Consecutive failed read-write attempts of a thread before it runs irrevocably
+#define IRREVOCABLE_RETRIES 8
+// Read-write attempts per contention window
+#define ADAPT_WINDOW 1024
+// Abort percentage over a window above which the region gets serialized
+#define ADAPT_ABORT_PERCENT 80
+// Serialized read-write transactions before probing the optimistic mode again
+#define SERIAL_WINDOW 4096
+// Serialized transactions of any kind, or time (in ns), after which the optimistic mode is probed again anyway
+#define SERIAL_BUDGET_BEGINS (4*SERIAL_WINDOW)
+#define SERIAL_BUDGET_NS 50000000ull
+
+// Region execution modes
+#define MODE_OPTIMISTIC 0   // Regular TL2 execution
+#define MODE_SERIAL 1       // Global reader-writer lock, no logging nor validation
+
+// Indicators of the running optimistic transactions, threads being spread over them
+#define MODE_SLOTS 64
+
+// Publication slots of the flat-combining commit path
+#define COMBINE_SLOTS 64
+// Failed commits in a row after which a thread commits through the combiner
+#define COMBINE_AFTER_ABORTS 4
+
+// Number of stripe buckets the threads parked by tm_retry are keyed by
+#define RETRY_BUCKETS 64
+
+// Status of a commit published to the combiner
+#define COMBINE_PENDING 0
+#define COMBINE_COMMITTED 1
+#define COMBINE_ABORTED 2
+
+// Linked lists to track read operations, deduplicated by stripe
 typedef struct rSet{
     lockStamp* ls;
+    word* addr;                 // Address of the word covered by the stripe
     struct rSet* next;
+    struct rSet* bucket_next;   // Next cell in the same index bucket
 } rSet;
 
+// Segments allocated by a transaction of a durable region, made live by its commit
+typedef struct allocList{
+    word* data;
+    struct allocList* next;
+} allocList;
+
 // Linked list structure to keep track of active transactions
 typedef struct transac{
     int rv;             // First clock counter
     int wv;             // Second clock counter
     wSet* wSet;         // wSet to track write operations
     rSet* rSet;         // rSet to track read operations
+    rSet* rIndex[RSET_BUCKETS]; // Index over rSet, to log each stripe once (only once upgraded)
+    bool upgraded;      // Performed a first write: rSet is deduplicated and indexed
+    unsigned int reads_since_check; // Reads logged since the last incremental validation
     bool is_ro;
+    bool is_irrevocable; // Holds the region's irrevocability token
+    bool is_serial;      // Runs in serialized mode, under the region's reader-writer lock
+    bool is_combining;   // Commits through the region's combiner
+    allocList* allocs;   // Segments allocated in a durable region, logged with the commit
 } transac;
 
+// Running optimistic transactions of the threads sharing an indicator, alone in its cache line
+typedef struct mode_slot{
+    atomic_int active;
+    char padding[64-sizeof(atomic_int)];
+} mode_slot;
+
+// Commit request published to the combiner
+typedef struct combine_slot{
+    _Atomic(transac*) request;  // Published transaction, NULL if the slot is free
+    atomic_int status;          // COMBINE_* status of the request
+    uint64_t lsn;               // Redo log position to wait for, once committed
+} combine_slot;
+
 /**
  * @brief List of dynamically allocated segments.
  */
@@ -48,6 +114,8 @@ typedef struct segment{
     lockStamp* locks;
     word* raw_data;
     struct segment* next;
+    bool borrowed_data;     // raw_data is not owned (durable file or image mapping)
+    bool borrowed_locks;    // locks are not owned (image mapping)
 } segment;
 typedef segment* segment_list;
 
@@ -61,9 +129,31 @@ typedef struct region{
     atomic_int clock;       // Global clock used for time-stamping, perfectible ?
     wSet* free_trick;
     pthread_mutex_t trick_lock;
+    atomic_bool irrevocable; // Token held by the (single) running irrevocable transaction
+    atomic_int mode;         // Current execution mode (MODE_*)
+    mode_slot optimistic_active[MODE_SLOTS]; // Running transactions in optimistic mode, per thread indicator
+    pthread_rwlock_t serial_lock; // Held by the transactions running in serialized mode
+    atomic_int window_attempts;   // Optimistic read-write attempts in the current window
+    atomic_int window_commits;    // Optimistic read-write commits in the current window
+    int serial_commits;      // Serialized read-write commits since the switch (under serial_lock)
+    atomic_int serial_begins;    // Serialized transactions begun since the switch
+    atomic_ullong serial_since;  // Time of the switch to the serialized mode (in ns)
+    atomic_ullong switches_serial;     // Switches to the serialized mode
+    atomic_ullong switches_optimistic; // Switches back to the optimistic mode
+    struct durable* durable; // Backing file and redo log, NULL for a volatile region
+    struct image_map* images; // Mappings of a loaded region image
+    atomic_bool combiner;    // Held by the thread applying the published commits
+    combine_slot combine_slots[COMBINE_SLOTS]; // Commits waiting for the combiner
+    atomic_int combine_seq;  // Futex word, bumped by each combiner as it leaves
+    atomic_int combine_sleepers; // Number of threads sleeping on combine_seq
+    atomic_int parked;       // Number of threads parked by tm_retry
+    atomic_int retry_waiters[RETRY_BUCKETS]; // Parked threads per stripe bucket
+    atomic_int retry_seq;    // Futex word, bumped by the commits waking parked threads
  } region;
 
 
+void init_region(region* tm_region, size_t align);
+segment* make_segment(word* raw_data, size_t len, int version);
 segment* find_segment(shared_t shared, word* target);
 void* add_segment(shared_t shared, segment* seg);
 
@@ -76,8 +166,28 @@ wSet* wSet_insert(wSet* node, word* addr, wSet* parent);
 bool wSet_acquire_locks(wSet* set);
 void wSet_release_locks(wSet* root, int wv_to_write);
 
-bool rSet_check(rSet* set, int wv, int rv);
+void rSet_append(transac* tx, lockStamp* ls, word* addr);
+void rSet_insert(transac* tx, lockStamp* ls, word* addr);
+void rSet_upgrade(transac* tx);
+bool rSet_validate(rSet* set, wSet* own, int rv);
+bool rSet_extend(region* tm_region, transac* tx);
+bool rSet_check(rSet* set, wSet* own, int wv, int rv);
+void wSet_absorb_delta(wSet* cell, void* value);
+void wSet_resolve_deltas(wSet* set);
 void wSet_commit_release(region* tm_region, wSet* set, int wv);
 
+bool commit_apply(region* tm_region, transac* tx, uint64_t* lsn);
+bool combine_commit(region* tm_region, transac* tx, uint64_t* lsn);
+
+bool commit_allowed(region* tm_region);
+void irrevocable_acquire(region* tm_region);
+void irrevocable_settle(lockStamp* ls);
+void irrevocable_release(region* tm_region);
+
+bool mode_enter(region* tm_region, bool is_ro);
+void mode_leave(region* tm_region, bool is_serial);
+void mode_sample_attempt(region* tm_region);
+void mode_serial_commit(region* tm_region);
+
 void abort_tr(region* tm_region, transac* tx);
 void tm_prepend_wSet_trick(region* reg, wSet* set);
\ No newline at end of file
@@ -30,18 +30,28 @@
 
 
 // External headers
+#include <sched.h>
 #include <stdatomic.h>
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
 // Internal headers
 #include <tm.h>
+#include <tm_ext.h>
 #include<unistd.h>
 
 #include "macros.h"
 #include "sets.h"
 #include "lockStamp.h"
+#include "tmExt.h"
+#include "durable.h"
+#include "image.h"
+#include "retry.h"
 
+// Consecutive read-write transactions begun by this thread without committing
+static _Thread_local unsigned int rw_attempts=0;
+// Failed commits of this thread in a row
+static _Thread_local unsigned int commit_aborts=0;
 
 /** Create (i.e. allocate + init) a new shared memory region, with one first non-free-able allocated segment of the requested size and alignment.
  * @param size  Size of the first shared segment of memory to allocate (in bytes), must be a positive multiple of the alignment
@@ -62,6 +72,7 @@ shared_t tm_create(size_t size, size_t align) {
         printf("Could not allocate region\n");
         return invalid_shared;
     }
+    tm_region->durable=NULL;
     // We create a segment entry for the non-deallocatable region
     segment* start_segment = (segment*) malloc(sizeof(segment));
     start_segment->len=len;
@@ -94,18 +105,45 @@ shared_t tm_create(size_t size, size_t align) {
         }
     }
     start_segment->next=NULL;
+    start_segment->borrowed_data=false;
+    start_segment->borrowed_locks=false;
     tm_region->segment_start=start_segment;
     tm_region->allocs      = start_segment;
-    tm_region->align       = align;
-    tm_region->free_trick  = NULL;
-    atomic_init(&(tm_region->clock), 0);
-    pthread_mutex_init(&(tm_region->trick_lock), NULL);
+    init_region(tm_region, align);
     // if(DEBUG){
     // 	printf("Region: %p, Region raw data start: %p\n", tm_region, tm_region->segment_start->raw_data);
     // }
     return tm_region;
 }
 
+/** Create a durable shared memory region backed by the given data file and its redo log '<path>.log', or recover it from them.
+ * @param size       Size of the first shared segment of memory to allocate (in bytes), must be a positive multiple of the alignment
+ * @param align      Alignment (in bytes, must be a power of 2) that the shared memory region must support
+ * @param path       Path of the data file, not backing any other open region
+ * @param latency_us Longest wait for concurrent commits to join a group sync (in microseconds), 0 for none
+ * @param capacity   Size of the data file, bounding every segment allocated (in bytes), 0 for the default; a recovered region keeps its own
+ * @param reset      Whether to discard the content of the files, instead of recovering it
+ * @return Opaque shared memory region handle, 'invalid_shared' on failure
+**/
+shared_t tm_create_durable(size_t size, size_t align, char const* path, long latency_us, size_t capacity, bool reset) {
+    if (unlikely(size%align)){
+        printf("Size not multiple of alignment");
+        return invalid_shared;
+    }
+    region* tm_region = (region*) malloc(sizeof(region));
+    if (unlikely(!tm_region)) {
+        printf("Could not allocate region\n");
+        return invalid_shared;
+    }
+    // The segments live in a file, and are recovered from it
+    if (unlikely(!durable_attach(tm_region, size, align, path, latency_us, capacity, reset))){
+        free(tm_region);
+        return invalid_shared;
+    }
+    init_region(tm_region, align);
+    return tm_region;
+}
+
 /** Destroy (i.e. clean-up + free) a given shared memory region.
  * @param shared Shared memory region to destroy, with no running transaction
 **/
@@ -116,16 +154,46 @@ void tm_destroy(shared_t shared) {
     region* tm_region = (region*) shared;
     while (tm_region->allocs) { // Free allocated segments
         segment_list tail = (tm_region->allocs)->next;
-        free(tm_region->allocs->locks);
-        free(tm_region->allocs->raw_data);
+        if (!tm_region->allocs->borrowed_locks){
+            free(tm_region->allocs->locks);
+        }
+        if (!tm_region->allocs->borrowed_data){
+            free(tm_region->allocs->raw_data);
+        }
         free(tm_region->allocs);
         tm_region->allocs = tail;
     }
+    if (tm_region->durable){
+        durable_close(tm_region->durable);
+    }
+    unmap_image(tm_region);
     clear_wSet(tm_region->free_trick);
     pthread_mutex_destroy(&(tm_region->trick_lock));
+    pthread_rwlock_destroy(&(tm_region->serial_lock));
     free(tm_region);
 }
 
+/** Save an image of the given shared memory region, which must have no running transaction.
+ * @param shared Shared memory region to save
+ * @param path   Path of the image file to write
+ * @return Whether the operation is a success
+**/
+bool tm_save_image(shared_t shared, char const* path) {
+    return save_image((region*) shared, path);
+}
+
+/** Create a shared memory region from an image, mapped lazily.
+ * @param path Path of the image file to load
+ * @return Opaque shared memory region handle, 'invalid_shared' on failure
+**/
+shared_t tm_load_image(char const* path) {
+    region* tm_region=load_image(path);
+    if (unlikely(!tm_region)){
+        return invalid_shared;
+    }
+    return tm_region;
+}
+
 /** [thread-safe] Return the start address of the first allocated segment in the shared memory region.
  * @param shared Shared memory region to query
  * @return Start address of the first allocated segment
@@ -171,7 +239,25 @@ size_t tm_align(shared_t shared) {
  * @return Opaque transaction ID, 'invalid_tx' on failure
 **/
 tx_t tm_begin(shared_t shared, bool is_ro) {
+    // A read-write transaction that keeps aborting falls back to irrevocable mode
+    if (!is_ro && unlikely(rw_attempts>=IRREVOCABLE_RETRIES)){
+        return tm_begin_ext(shared, is_ro, TM_IRREVOCABLE);
+    }
+    return tm_begin_ext(shared, is_ro, 0);
+}
+
+/** [thread-safe] Begin a new transaction on the given shared memory region, with extra flags.
+ * @param shared Shared memory region to start a transaction on
+ * @param is_ro  Whether the transaction is read-only
+ * @param flags  Combination of TM_* flags
+ * @return Opaque transaction ID, 'invalid_tx' on failure
+**/
+tx_t tm_begin_ext(shared_t shared, bool is_ro, unsigned int flags) {
     region* tm_region = (region*) shared;
+    if (unlikely(!is_ro && tm_region->durable && atomic_load(&(tm_region->durable->failed)))){
+        // Its commit would be refused: fail now, instead of letting the caller retry forever
+        return invalid_tx;
+    }
     transac* tr = (transac*)malloc(sizeof(transac));
     if (unlikely(!tr)){
         printf("Could not create a transaction");
@@ -179,7 +265,23 @@ tx_t tm_begin(shared_t shared, bool is_ro) {
     }
     tr->rSet=NULL;
     tr->wSet=NULL;
+    tr->allocs=NULL;
     tr->is_ro=is_ro;
+    tr->is_serial=mode_enter(tm_region, is_ro);
+    // A serialized transaction cannot abort anyway
+    tr->is_irrevocable=!is_ro && !tr->is_serial && (flags&TM_IRREVOCABLE);
+    tr->upgraded=false;
+    tr->is_combining=!is_ro && ((flags&TM_COMBINE) || commit_aborts>=COMBINE_AFTER_ABORTS);
+    if (!is_ro){
+        tr->reads_since_check=0;
+        rw_attempts++;
+        if (!tr->is_serial){
+            mode_sample_attempt(tm_region);
+        }
+    }
+    if (tr->is_irrevocable){
+        irrevocable_acquire(tm_region);
+    }
     tr->rv= atomic_load(&(tm_region->clock));
     tr->wv=-1;
     // if(DEBUG>1){
@@ -200,38 +302,75 @@ bool tm_end(shared_t shared, tx_t tx) {
     region* tm_region = (region*) shared;
     transac* tr=(transac*)tx;
 
-    if (!tr->is_ro){
-        // Acquire locks on wSet
-        if(!wSet_acquire_locks(tr->wSet)){
-            // tr->wSet=NULL;
-            // if(DEBUG){
-            // 	printf("Failed transaction, cannot acquire wSet\n");
-            // }
+    durable* log=NULL; // Redo log to sync the commit to, for a durable region
+    uint64_t lsn=0;
+    if (tm_region->durable && !tr->is_ro && !tr->is_serial && (tr->wSet || tr->allocs)){
+        // Refused once the redo log failed (before anything is visible), and counted so that the flusher knows a commit is on its way
+        if (unlikely(!durable_commit_begin(tm_region->durable))){
             abort_tr(tm_region, tr);
             return false;
         }
-        // Sample secondary (write-version) clock
-        tr->wv=atomic_fetch_add(&(tm_region->clock), 1)+1;
-
-        // Check rSet state
-        if(!rSet_check(tr->rSet, tr->wv,tr->rv)){
-            tr->rSet=NULL;
-            wSet_release_locks(tr->wSet, -1);
-            // tr->wSet=NULL;
+        log=tm_region->durable;
+    }
+    if (tr->is_serial){
+        // Writes were done in place, under the exclusive lock
+        if (!tr->is_ro){
+            // Tick the clock anyway, so that threads parked by tm_retry notice the commit
+            atomic_fetch_add(&(tm_region->clock), 1);
+            retry_wake(tm_region, ~0ull);
+            mode_serial_commit(tm_region);
+            rw_attempts=0;
+        }
+    }else if (tr->is_irrevocable){
+        // No commit can begin anymore: the only locks still held are released soon, and reads are still valid
+        if (tr->wSet || tr->allocs){
+            while (!wSet_acquire_locks(tr->wSet)){
+                sched_yield();
+            }
+            tr->wv=atomic_fetch_add(&(tm_region->clock), 1)+1;
+            wSet_resolve_deltas(tr->wSet);
+            lsn=log?durable_log_commit(log, tr->wSet, tr->allocs):0;
+            uint64_t wake=retry_wSet_mask(tm_region, tr->wSet);
+            wSet_commit_release(tm_region, tr->wSet, tr->wv);
+            tr->wSet=NULL;
+            retry_wake(tm_region, wake);
+        }
+        atomic_fetch_add(&(tm_region->window_commits), 1);
+        rw_attempts=0;
+    }else if (!tr->is_ro && !tr->wSet){
+        // Nothing written: every read was valid at rv, commit as read-only (its allocations still become live)
+        lsn=log?durable_log_commit(log, NULL, tr->allocs):0;
+        atomic_fetch_add(&(tm_region->window_commits), 1);
+        rw_attempts=0;
+    }else if (!tr->is_ro){
+        // Hot transactions hand their commit to the combiner instead of racing for the locks
+        bool committed=tr->is_combining?combine_commit(tm_region, tr, &lsn):commit_apply(tm_region, tr, &lsn);
+        if (!committed){
             // if(DEBUG){
-            // 	printf("Failed transaction, wrong rSet state\n");
+            // 	printf("Failed transaction, cannot acquire wSet or wrong rSet state\n");
             // }
+            commit_aborts++;
+            if (log){
+                durable_commit_end(log);
+            }
             abort_tr(tm_region, tr);
             return false;
         }
-        tr->rSet=NULL;
-        // Commit wSet, release locks and write clocks
-        wSet_commit_release(tm_region, tr->wSet, tr->wv);
-        tr->wSet=NULL;
+        commit_aborts=0;
+        atomic_fetch_add(&(tm_region->window_commits), 1);
+        rw_attempts=0;
         // if (DEBUG>1){
         //     printf("Commit succeeded, releasing locks, writing wv:%d\n", tr->wv);
         // }
     }
+    if (log){
+        // Group commit: wait for the flusher to sync our records
+        if (unlikely(!durable_wait(log, lsn))){
+            // The writes are visible already: the commit stands, only its durability is lost
+            atomic_fetch_add(&(log->unsynced), 1);
+        }
+        durable_commit_end(log);
+    }
     abort_tr(tm_region, tr);
     // if(DEBUG>1){
     // 	printf("[OK]= End TX: %03lx\n", tx);
@@ -239,6 +378,35 @@ bool tm_end(shared_t shared, tx_t tx) {
     return true;
 }
 
+/** [thread-safe] Abort the given transaction, and block until a commit may have changed what it read.
+ * The caller then runs the transaction again, e.g. when a condition it waits for does not hold yet.
+ * It must come before the first write, as serialized transactions write in place.
+ * @param shared Shared memory region associated with the transaction
+ * @param tx     Transaction to retry
+ * @return Always false, as the transaction is aborted
+**/
+bool tm_retry(shared_t shared, tx_t tx) {
+    region* tm_region = (region*) shared;
+    transac* tr=(transac*)tx;
+    int rv=tr->rv;
+    // Only optimistic read-write transactions log their reads
+    rSet* set=NULL;
+    if (!tr->is_ro && !tr->is_serial && !tr->is_irrevocable){
+        set=tr->rSet;
+        tr->rSet=NULL;
+    }
+    if (!tr->is_ro && !tr->is_serial){
+        // Waiting is no contention: do not push the region towards serialization
+        atomic_fetch_add(&(tm_region->window_commits), 1);
+    }
+    rw_attempts=0;
+    // Leave the transaction first: its mode and tokens must not block the committers we wait for
+    abort_tr(tm_region, tr);
+    retry_park(tm_region, set, rv);
+    clear_rSet(set);
+    return false;
+}
+
 /** [thread-safe] Read operation in the given transaction, source in the shared region and target in a private region.
  * @param shared Shared memory region associated with the transaction
  * @param tx     Transaction to use
@@ -254,13 +422,17 @@ bool tm_read(shared_t shared, tx_t tx, void const* source, size_t size, void* ta
     region* tm_region = (region*) shared;
     transac* tr=(transac*)tx;
     lockStamp* ls;
-    segment* seg=find_segment(shared, (word*) source);
 
     if (unlikely(size%tm_region->align)){
         printf("Size not multiple of alignment");
         abort_tr(tm_region, tr);
         return false;
     }
+    if (tr->is_serial){
+        memcpy(target, source, size);
+        return true;
+    }
+    segment* seg=find_segment(shared, (word*) source);
     if (unlikely(!seg)){
         if (DEBUG){
             printf("Could not find segment for source %p (call: Read (sh)%p to (priv)%p, %ld bytes)\n", source, source, target, size);
@@ -282,15 +454,25 @@ bool tm_read(shared_t shared, tx_t tx, void const* source, size_t size, void* ta
             // if(DEBUG>2){
             // 	printf("Direct find in read: %d\n", found_wSet!=NULL);
             // }
-            if (found_wSet){
+            if (found_wSet && !found_wSet->is_delta){
                 memcpy((target+i*tm_region->align),found_wSet->src, tm_region->align);
                 continue;
             }
         }
 
+        if (tr->is_irrevocable){
+            // Memory cannot change under an irrevocable transaction, once the commits begun before it are done
+            irrevocable_settle(&(seg->locks[i+offset]));
+            memcpy((target+i*tm_region->align),source+i*tm_region->align, tm_region->align);
+            if (found_wSet){
+                wSet_absorb_delta(found_wSet, target+i*tm_region->align);
+            }
+            continue;
+        }
         ls=&(seg->locks[i+offset]);
         prev_versionStamp=ls->versionStamp;
-        if (prev_versionStamp>tr->rv){
+        // Newer stripe: try to extend the snapshot instead of aborting right away
+        if (prev_versionStamp>tr->rv && (tr->is_ro || !rSet_extend(tm_region, tr))){
             abort_tr(tm_region, tr);
             return false;
         }
@@ -305,11 +487,24 @@ bool tm_read(shared_t shared, tx_t tx, void const* source, size_t size, void* ta
             abort_tr(tm_region, tr);
             return false;
         }
-        if (!tr->is_ro && !found_wSet){
-            rSet* newRCell= (rSet*) malloc(sizeof(rSet));
-            newRCell->ls=ls;
-            newRCell->next=tr->rSet;
-            tr->rSet=newRCell;
+        if (found_wSet){
+            // Pending delta: the word is now read, it becomes a plain write
+            wSet_absorb_delta(found_wSet, target+i*tm_region->align);
+        }
+        if (!tr->is_ro){
+            if (tr->upgraded){
+                rSet_insert(tr, ls, (word*) (source+i*tm_region->align));
+            }else{
+                rSet_append(tr, ls, (word*) (source+i*tm_region->align));
+            }
+            // Periodically revalidate if the clock moved, so that doomed transactions abort early
+            if (++tr->reads_since_check>=VALIDATION_PERIOD){
+                tr->reads_since_check=0;
+                if (!rSet_extend(tm_region, tr)){
+                    abort_tr(tm_region, tr);
+                    return false;
+                }
+            }
         }
     }
     // if(DEBUG>1){
@@ -318,6 +513,120 @@ bool tm_read(shared_t shared, tx_t tx, void const* source, size_t size, void* ta
     return true;
 }
 
+/** [thread-safe] Bulk read operation in the given transaction: the range is copied at once, and validated in one pass.
+ * @param shared Shared memory region associated with the transaction
+ * @param tx     Transaction to use
+ * @param source Source start address (in the shared region)
+ * @param size   Length to copy (in bytes), must be a positive multiple of the alignment
+ * @param target Target start address (in a private region)
+ * @return Whether the whole transaction can continue
+**/
+bool tm_read_range(shared_t shared, tx_t tx, void const* source, size_t size, void* target) {
+    region* tm_region = (region*) shared;
+    transac* tr=(transac*)tx;
+
+    if (unlikely(size%tm_region->align)){
+        printf("Size not multiple of alignment\n");
+        abort_tr(tm_region, tr);
+        return false;
+    }
+    if (tr->is_serial){
+        memcpy(target, source, size);
+        return true;
+    }
+    segment* seg=find_segment(shared, (word*) source);
+    if (unlikely(!seg)){
+        if (DEBUG){
+            printf("Could not find segment for source %p (call: Read range (sh)%p to (priv)%p, %ld bytes)\n", source, source, target, size);
+        }
+        abort_tr(tm_region, tr);
+        return false;
+    }
+    size_t offset = (source-seg->raw_data)/tm_region->align;
+    size_t len=size/tm_region->align;
+    if (unlikely(offset+len>seg->len)){
+        // The range spans several segments: validate word by word
+        return tm_read(shared, tx, source, size, target);
+    }
+    lockStamp* locks=&(seg->locks[offset]);
+    if (!tr->is_irrevocable){
+        // Sample the stripes: none may be locked or newer than the snapshot
+        uint64_t prev_sum;
+        bool extended=false;
+        size_t i;
+        while (true){
+            prev_sum=0;
+            for (i=0;i<len;i++){
+                if (test_lockstamp(&(locks[i])) || locks[i].versionStamp>tr->rv){
+                    break;
+                }
+                prev_sum+=locks[i].versionStamp;
+            }
+            if (i==len){
+                break;
+            }
+            if (tr->is_ro || extended || !rSet_extend(tm_region, tr)){
+                abort_tr(tm_region, tr);
+                return false;
+            }
+            extended=true;
+        }
+        memcpy(target, source, size);
+        // Stamps only grow, so an unchanged sum means no stripe was committed to during the copy
+        uint64_t post_sum=0;
+        for (i=0;i<len;i++){
+            if (test_lockstamp(&(locks[i]))){
+                abort_tr(tm_region, tr);
+                return false;
+            }
+            post_sum+=locks[i].versionStamp;
+        }
+        if (post_sum!=prev_sum){
+            abort_tr(tm_region, tr);
+            return false;
+        }
+    }else{
+        // Memory cannot change under an irrevocable transaction, once the commits begun before it are done
+        for (size_t i=0;i<len;i++){
+            irrevocable_settle(&(locks[i]));
+        }
+        memcpy(target, source, size);
+    }
+    if (tr->is_ro){
+        return true;
+    }
+    // Overlay our own writes, and log the other words for commit-time validation
+    for (size_t i=0;i<len;i++){
+        word* addr=(word*) (source+i*tm_region->align);
+        wSet* found_wSet=wSet_contains(addr, tr->wSet);
+        if (found_wSet && !found_wSet->is_delta){
+            memcpy((target+i*tm_region->align), found_wSet->src, tm_region->align);
+            continue;
+        }
+        if (found_wSet){
+            wSet_absorb_delta(found_wSet, target+i*tm_region->align);
+        }
+        if (!tr->is_irrevocable){
+            if (tr->upgraded){
+                rSet_insert(tr, &(locks[i]), addr);
+            }else{
+                rSet_append(tr, &(locks[i]), addr);
+            }
+        }
+    }
+    if (!tr->is_irrevocable){
+        tr->reads_since_check+=len;
+        if (tr->reads_since_check>=VALIDATION_PERIOD){
+            tr->reads_since_check=0;
+            if (!rSet_extend(tm_region, tr)){
+                abort_tr(tm_region, tr);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 /** [thread-safe] Write operation in the given transaction, source in a private region and target in the shared region.
  * @param shared Shared memory region associated with the transaction
  * @param tx     Transaction to use
@@ -338,6 +647,10 @@ bool tm_write(shared_t shared, tx_t tx, void const* source, size_t size, void* t
         abort_tr(tm_region, tr);
         return false;
     }
+    if (tr->is_serial && likely(!tr->is_ro)){
+        memcpy(target, source, size);
+        return true;
+    }
     size_t len = size/tm_region->align;
     segment* seg=find_segment(shared, (word*) target);
     if (unlikely(!seg)){
@@ -355,11 +668,16 @@ bool tm_write(shared_t shared, tx_t tx, void const* source, size_t size, void* t
         abort_tr(tm_region, tr);
         return false;
     }
+    if (!tr->upgraded && !tr->is_irrevocable){
+        // First write: the read set is now needed at commit, deduplicate it
+        rSet_upgrade(tr);
+    }
     wSet* found_wSet=NULL;
     for(size_t i=0;i<len;i++){
         found_wSet=wSet_contains((word*) (target+i*tm_region->align), tr->wSet);
         if (found_wSet){
             memcpy(found_wSet->src,source+i*tm_region->align,tm_region->align);
+            found_wSet->is_delta=false;
         }else{
             wSet* newWCell= (wSet*) malloc(sizeof(wSet));
             newWCell->dest=(word*)(target+i*tm_region->align);
@@ -369,6 +687,8 @@ bool tm_write(shared_t shared, tx_t tx, void const* source, size_t size, void* t
             newWCell->left=NULL;
             newWCell->right=NULL;
             newWCell->free_trick_link=NULL;
+            newWCell->is_delta=false;
+            newWCell->folded_into=NULL;
             tr->wSet=wSet_insert(newWCell, newWCell->dest, tr->wSet);
         }
     }
@@ -378,6 +698,67 @@ bool tm_write(shared_t shared, tx_t tx, void const* source, size_t size, void* t
     return true;
 }
 
+/** [thread-safe] Add a delta to a 64-bit word in the given transaction, without reading it.
+ * Additions to the same word by concurrent transactions do not conflict.
+ * @param shared Shared memory region associated with the transaction
+ * @param tx     Transaction to use
+ * @param target Target word address (in the shared region), the alignment must be 8 bytes
+ * @param delta  Value to add to the word at commit time
+ * @return Whether the whole transaction can continue
+**/
+bool tm_add(shared_t shared, tx_t tx, void* target, int64_t delta) {
+    region* tm_region = (region*) shared;
+    transac* tr=(transac*)tx;
+
+    if (unlikely(tm_region->align!=sizeof(int64_t))){
+        printf("Deltas need 8-byte words\n");
+        abort_tr(tm_region, tr);
+        return false;
+    }
+    if (unlikely(tr->is_ro)){
+        printf("WO transaction trying to write !\n");
+        abort_tr(tm_region, tr);
+        return false;
+    }
+    if (tr->is_serial){
+        int64_t value;
+        memcpy(&value, target, sizeof(int64_t));
+        value+=delta;
+        memcpy(target, &value, sizeof(int64_t));
+        return true;
+    }
+    segment* seg=find_segment(shared, (word*) target);
+    if (unlikely(!seg)){
+        printf("Could not find segment for target %p\n", target);
+        abort_tr(tm_region, tr);
+        return false;
+    }
+    if (!tr->upgraded && !tr->is_irrevocable){
+        rSet_upgrade(tr);
+    }
+    wSet* found_wSet=wSet_contains((word*) target, tr->wSet);
+    if (found_wSet){
+        // Adding works the same on a pending value and on a pending delta
+        int64_t value;
+        memcpy(&value, found_wSet->src, sizeof(int64_t));
+        value+=delta;
+        memcpy(found_wSet->src, &value, sizeof(int64_t));
+        return true;
+    }
+    wSet* newWCell= (wSet*) malloc(sizeof(wSet));
+    newWCell->dest=(word*) target;
+    newWCell->src=malloc(sizeof(int64_t));
+    memcpy(newWCell->src, &delta, sizeof(int64_t));
+    newWCell->ls=&(seg->locks[(target-seg->raw_data)/tm_region->align]);
+    newWCell->left=NULL;
+    newWCell->right=NULL;
+    newWCell->free_trick_link=NULL;
+    newWCell->is_delta=true;
+    newWCell->folded_into=NULL;
+    tr->wSet=wSet_insert(newWCell, newWCell->dest, tr->wSet);
+    return true;
+}
+
 /** [thread-safe] Memory allocation in the given transaction.
  * @param shared Shared memory region associated with the transaction
  * @param tx     Transaction to use
@@ -398,12 +779,33 @@ alloc_t tm_alloc(shared_t shared, tx_t tx, size_t size, void** target) {
     }
     size_t len = size/tm_region->align;
 
+    if (tm_region->durable){
+        word* raw_data=durable_alloc(tm_region->durable, size);
+        segment* newSeg=raw_data?make_segment(raw_data, len, tr->rv):NULL;
+        allocList* cell=newSeg?(allocList*) malloc(sizeof(allocList)):NULL;
+        if (unlikely(!cell)){
+            if (newSeg){
+                free(newSeg->locks);
+                free(newSeg);
+            }
+            printf("Could not allocate durable segment\n");
+            return nomem_alloc;
+        }
+        // Made live in the data file by the commit only
+        cell->data=raw_data;
+        cell->next=tr->allocs;
+        tr->allocs=cell;
+        *target=add_segment(shared, newSeg);
+        return success_alloc;
+    }
     segment* newSeg = (segment*) malloc(sizeof(segment));
     if (unlikely(!newSeg)){
         printf("Could not allocate segment\n");
         return nomem_alloc;
     }
     newSeg->len=len;
+    newSeg->borrowed_data=false;
+    newSeg->borrowed_locks=false;
     if (unlikely(posix_memalign((void*)&(newSeg->raw_data),tm_region->align,size) !=0)){
         free(newSeg->raw_data);
         free(newSeg);
@@ -444,4 +846,81 @@ bool tm_free(unused(shared_t shared), unused(tx_t tx), unused(void* target)) {
     // 	printf("TX: %03lx, Free: %p\n", tx, target);
     // }
     return true;
-}
\ No newline at end of file
+}
+
+/** Get the statistics of the given shared memory region.
+ * @param shared   Shared memory region
+ * @param stats    Statistics to fill, at most 'capacity' of them
+ * @param capacity Number of statistics 'stats' can hold
+ * @return Number of statistics available
+**/
+static size_t ext_stats(shared_t shared, struct tm_ext_stat* stats, size_t capacity) {
+    region* tm_region = (region*) shared;
+    struct tm_ext_stat all[]={
+        {"clock", (uint64_t) atomic_load(&(tm_region->clock))},
+        {"serial_mode", atomic_load(&(tm_region->mode))==MODE_SERIAL},
+        {"switches_to_serial", (uint64_t) atomic_load(&(tm_region->switches_serial))},
+        {"switches_to_optimistic", (uint64_t) atomic_load(&(tm_region->switches_optimistic))},
+        {"parked", (uint64_t) atomic_load(&(tm_region->parked))},
+        {"durable_failed", tm_region->durable && atomic_load(&(tm_region->durable->failed))},
+        {"durable_unsynced", tm_region->durable?(uint64_t) atomic_load(&(tm_region->durable->unsynced)):0},
+    };
+    size_t count=sizeof(all)/sizeof(*all);
+    for (size_t i=0;i<count && i<capacity;i++){
+        stats[i]=all[i];
+    }
+    return count;
+}
+
+/** Reset the calling thread's retry history, which must not carry over from another region.
+ * @param shared Shared memory region
+**/
+static void ext_thread_init(unused(shared_t shared)) {
+    rw_attempts=0;
+    commit_aborts=0;
+}
+
+/** End the given transaction on purpose, without committing it.
+ * @param shared Shared memory region associated with the transaction
+ * @param tx     Transaction to abort
+ * @return Whether its writes were discarded, false for a serialized transaction that wrote in place (it then commits)
+**/
+static bool ext_abort(shared_t shared, tx_t tx) {
+    region* tm_region = (region*) shared;
+    transac* tr=(transac*)tx;
+    if (tr->is_serial && !tr->is_ro){
+        tm_end(shared, tx);
+        return false;
+    }
+    if (!tr->is_ro){
+        // Giving up is no contention: do not push the region towards serialization
+        atomic_fetch_add(&(tm_region->window_commits), 1);
+    }
+    rw_attempts=0;
+    abort_tr(tm_region, tr);
+    return true;
+}
+
+/** Get the library's extension table.
+ * @param version 'TM_EXT_VERSION' the caller was built with
+ * @return Extension table, NULL if that version is not supported
+**/
+struct tm_ext const* tm_ext_query(uint32_t version) {
+    static struct tm_ext const ext={
+        .version=TM_EXT_VERSION,
+        .size=sizeof(struct tm_ext),
+        .read_range=tm_read_range,
+        .read_word=NULL,   // tm_read has no cheaper single-word path
+        .write_word=NULL,
+        .stats=ext_stats,
+        .thread_init=ext_thread_init,
+        .thread_fini=ext_thread_init,
+        .abort=ext_abort,
+        .create_durable=tm_create_durable,
+        .add=tm_add,
+    };
+    if (version!=TM_EXT_VERSION){
+        return NULL;
+    }
+    return &ext;
+}
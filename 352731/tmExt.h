@@ -0,0 +1,77 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <tm.h>
+
+// Extended entry points, on top of the ones declared in tm.h
+
+// Flags accepted by tm_begin_ext
+#define TM_IRREVOCABLE 0x1  // Run serially: the transaction cannot abort
+#define TM_COMBINE 0x2      // Commit through the region's combiner, for hot-spot writes
+
+/** [thread-safe] Begin a new transaction on the given shared memory region, with extra flags.
+ * @param shared Shared memory region to start a transaction on
+ * @param is_ro  Whether the transaction is read-only
+ * @param flags  Combination of the TM_* flags above
+ * @return Opaque transaction ID, 'invalid_tx' on failure
+**/
+tx_t tm_begin_ext(shared_t shared, bool is_ro, unsigned int flags);
+
+/** Create a durable shared memory region backed by the given data file and its redo log '<path>.log', or recover it from them.
+ * A commit returns once its writes are synced to the redo log. After a write or a sync of either file failed, the region
+ * refuses every further commit: the read-write transactions that already began abort, and 'tm_begin' fails for the later ones.
+ * The commits still waiting for their sync then succeed nonetheless, their writes being visible already, and are counted as
+ * "durable_unsynced" in the region's statistics.
+ * @param size       Size of the first shared segment of memory to allocate (in bytes), must be a positive multiple of the alignment
+ * @param align      Alignment (in bytes, must be a power of 2) that the shared memory region must support
+ * @param path       Path of the data file, not backing any other open region
+ * @param latency_us Longest wait for concurrent commits to join a group sync (in microseconds), 0 for none
+ * @param capacity   Size of the data file, bounding every segment allocated (in bytes), 0 for the default; a recovered region keeps its own
+ * @param reset      Whether to discard the content of the files, instead of recovering it
+ * @return Opaque shared memory region handle, 'invalid_shared' on failure
+**/
+shared_t tm_create_durable(size_t size, size_t align, char const* path, long latency_us, size_t capacity, bool reset);
+
+/** Save an image of the given shared memory region, which must have no running transaction.
+ * @param shared Shared memory region to save
+ * @param path   Path of the image file to write
+ * @return Whether the operation is a success
+**/
+bool tm_save_image(shared_t shared, char const* path);
+
+/** Create a shared memory region from an image, mapped lazily.
+ * @param path Path of the image file to load
+ * @return Opaque shared memory region handle, 'invalid_shared' on failure
+**/
+shared_t tm_load_image(char const* path);
+
+/** [thread-safe] Bulk read operation in the given transaction, source in the shared region and target in a private region.
+ * The range is copied at once and validated in a single pass over its stripes, which suits long scans.
+ * @param shared Shared memory region associated with the transaction
+ * @param tx     Transaction to use
+ * @param source Source start address (in the shared region)
+ * @param size   Length to copy (in bytes), must be a positive multiple of the alignment
+ * @param target Target start address (in a private region)
+ * @return Whether the whole transaction can continue
+**/
+bool tm_read_range(shared_t shared, tx_t tx, void const* source, size_t size, void* target);
+
+/** [thread-safe] Add a delta to a 64-bit word in the given transaction, without reading it.
+ * Additions to the same word by concurrent transactions do not conflict.
+ * @param shared Shared memory region associated with the transaction
+ * @param tx     Transaction to use
+ * @param target Target word address (in the shared region), the alignment must be 8 bytes
+ * @param delta  Value to add to the word at commit time
+ * @return Whether the whole transaction can continue
+**/
+bool tm_add(shared_t shared, tx_t tx, void* target, int64_t delta);
+
+/** [thread-safe] Abort the given transaction, and block until a commit may have changed what it read.
+ * The caller then runs the transaction again, e.g. when a condition it waits for does not hold yet.
+ * It must come before the first write, as serialized transactions write in place.
+ * @param shared Shared memory region associated with the transaction
+ * @param tx     Transaction to retry
+ * @return Always false, as the transaction is aborted
+**/
+bool tm_retry(shared_t shared, tx_t tx);
@@ -24,8 +24,10 @@
 #pragma once
 
 // External headers
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cmath>
 #include <condition_variable>
 #include <cstddef>
 #include <cstdint>
@@ -115,6 +117,7 @@ public:
 EXCEPTION(Unreachable, Any, "unreachable code reached");
 EXCEPTION(Bounded, Any, "bounded execution exception");
     EXCEPTION(BoundedOverrun, Any, "bounded execution overrun");
+EXCEPTION(Parameter, Any, "invalid run parameter");
 
 }
 // -------------------------------------------------------------------------- //
@@ -151,12 +154,13 @@ public:
     Chrono(Tick tick = 0) noexcept: total{tick} {}
 private:
     /** Call a "clock" function, convert the result to the Tick type.
-     * @param func "Clock" function to call
+     * @param func  "Clock" function to call
+     * @param clock Clock to use
      * @return Resulting time
     **/
-    static Tick convert(int (*func)(::clockid_t, struct ::timespec*)) noexcept {
+    static Tick convert(int (*func)(::clockid_t, struct ::timespec*), ::clockid_t clock = CLOCK_MONOTONIC) noexcept {
         struct ::timespec buf;
-        if (unlikely(func(CLOCK_MONOTONIC, &buf) < 0))
+        if (unlikely(func(clock, &buf) < 0))
             return invalid_tick;
         auto res = static_cast<Tick>(buf.tv_nsec) + static_cast<Tick>(buf.tv_sec) * static_cast<Tick>(1000000000ul);
         if (unlikely(res == invalid_tick)) // Bad luck...
@@ -170,6 +174,12 @@ public:
     static auto get_resolution() noexcept {
         return convert(::clock_getres);
     }
+    /** Get the CPU time consumed so far by the calling thread.
+     * @return CPU time (in ns), 'invalid_tick' for unknown
+    **/
+    static auto get_thread_time() noexcept {
+        return convert(::clock_gettime, CLOCK_THREAD_CPUTIME_ID);
+    }
 public:
     /** Start measuring a time segment.
     **/
@@ -250,6 +260,104 @@ public:
     }
 };
 
+/** Log-linear histogram class (HDR-style), with a relative precision of 1/32 on the recorded values.
+**/
+class Histogram final {
+public:
+    /** Value class.
+    **/
+    using Value = uint_fast64_t;
+private:
+    constexpr static auto sub_bits    = 5; // Sub-buckets per power of 2 (as a power of 2)
+    constexpr static auto sub_count   = size_t{1} << sub_bits;
+    constexpr static auto nb_buckets  = (65 - sub_bits) * sub_count; // Enough for any 64-bit value, the top bit included
+    uint_fast64_t counts[nb_buckets]; // Number of recorded values per bucket
+    uint_fast64_t total; // Number of recorded values
+    Value         max;   // Largest recorded value
+    double        sum;   // Sum of the recorded values
+private:
+    /** Get the bucket of a value.
+     * @param value Value
+     * @return Bucket index
+    **/
+    constexpr static size_t bucket(Value value) noexcept {
+        if (value < 2 * sub_count) // Exact values
+            return static_cast<size_t>(value);
+        auto shift = 63 - __builtin_clzll(value) - sub_bits;
+        return static_cast<size_t>(shift + 1) * sub_count + static_cast<size_t>(value >> shift) - sub_count;
+    }
+    /** Get the largest value of a bucket.
+     * @param index Bucket index
+     * @return Largest value falling in that bucket
+    **/
+    constexpr static Value highest(size_t index) noexcept {
+        if (index < 2 * sub_count)
+            return index;
+        auto shift = index / sub_count - 1;
+        return ((static_cast<Value>(sub_count + index % sub_count) + 1) << shift) - 1;
+    }
+public:
+    /** Empty histogram constructor.
+    **/
+    Histogram() noexcept: counts{}, total{0}, max{0}, sum{0.} {}
+public:
+    /** Record one value.
+     * @param value Value to record
+    **/
+    void record(Value value) noexcept {
+        ++counts[bucket(value)];
+        ++total;
+        if (value > max)
+            max = value;
+        sum += static_cast<double>(value);
+    }
+    /** Add the values recorded by another histogram.
+     * @param other Histogram to merge in
+    **/
+    void merge(Histogram const& other) noexcept {
+        for (size_t i = 0; i < nb_buckets; ++i)
+            counts[i] += other.counts[i];
+        total += other.total;
+        if (other.max > max)
+            max = other.max;
+        sum += other.sum;
+    }
+    /** Get the number of recorded values.
+     * @return Number of recorded values
+    **/
+    auto get_count() const noexcept {
+        return total;
+    }
+    /** Get the largest recorded value.
+     * @return Largest recorded value, 0 if none
+    **/
+    auto get_max() const noexcept {
+        return max;
+    }
+    /** Get the mean of the recorded values.
+     * @return Mean of the recorded values, 0 if none
+    **/
+    double get_mean() const noexcept {
+        return total > 0 ? sum / static_cast<double>(total) : 0.;
+    }
+    /** Get a percentile of the recorded values, up to the precision of the histogram.
+     * @param ratio Ratio of the values that are lower or equal to the returned value (in [0, 1])
+     * @return Smallest bucket bound covering that ratio of the recorded values, 0 if none
+    **/
+    Value get_percentile(double ratio) const noexcept {
+        auto rank = static_cast<uint_fast64_t>(::std::ceil(ratio * static_cast<double>(total)));
+        if (rank == 0)
+            rank = 1;
+        uint_fast64_t seen = 0;
+        for (size_t i = 0; i < nb_buckets; ++i) {
+            seen += counts[i];
+            if (seen >= rank)
+                return ::std::min(highest(i), max);
+        }
+        return max;
+    }
+};
+
 // -------------------------------------------------------------------------- //
 
 /** Pause execution for a "short" period of time.
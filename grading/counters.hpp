@@ -0,0 +1,201 @@
+/**
+ * @file   counters.hpp
+ *
+ * @section DESCRIPTION
+ *
+ * Per-thread hardware performance counters, through 'perf_event_open'.
+ *
+ * Every counter that cannot be opened (no PMU, e.g. in a VM, or a restrictive
+ * 'perf_event_paranoid') is reported unavailable, while the others keep counting.
+**/
+
+#pragma once
+
+// External headers
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Internal headers
+#include "common.hpp"
+
+// -------------------------------------------------------------------------- //
+
+/** Per-thread group of performance counters, counting user-space events of the calling thread.
+**/
+class PerfCounters final: private NonCopyable {
+public:
+    /** Counted event enum.
+    **/
+    enum Event: size_t {
+        instructions,
+        cycles,
+        llc_misses,
+        branch_misses,
+        context_switches,
+        nb_events
+    };
+    /** Event names, in event order.
+    **/
+    constexpr static char const* names[nb_events] = {"instructions", "cycles", "LLC misses", "branch misses", "context switches"};
+    /** Event keys in machine-readable reports, in event order.
+    **/
+    constexpr static char const* keys[nb_events] = {"instructions", "cycles", "llc_misses", "branch_misses", "context_switches"};
+    /** Event totals, NaN for an unavailable counter.
+    **/
+    struct Values final {
+        double values[nb_events];
+        /** Zero constructor.
+        **/
+        Values() noexcept {
+            for (auto&& value: values)
+                value = 0.;
+        }
+        /** Add other totals, an unavailable counter making the sum unavailable.
+         * @param other Totals to add
+        **/
+        void merge(Values const& other) noexcept {
+            for (size_t i = 0; i < nb_events; ++i)
+                values[i] += other.values[i];
+        }
+        /** Tell whether every counter was unavailable.
+         * @return Whether no counter was available
+        **/
+        bool none() const noexcept {
+            for (auto&& value: values) {
+                if (!::std::isnan(value))
+                    return false;
+            }
+            return true;
+        }
+    };
+private:
+    /** Counter value, as read with 'PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING'.
+    **/
+    struct Reading final {
+        uint64_t value;
+        uint64_t enabled;
+        uint64_t running;
+    };
+private:
+    int fds[nb_events]; // File descriptor of each counter, -1 if unavailable
+    int error;          // 'errno' of the first counter that could not be opened, 0 for none
+    Values totals;      // Totals since construction
+private:
+    /** Open one counter for the calling thread.
+     * @param type   Event type
+     * @param config Event configuration
+     * @param group  Group leader's file descriptor, -1 to lead a new group
+     * @param user   Whether to count user-space events only (kernel events are needed for software events)
+     * @return File descriptor, -1 on failure
+    **/
+    static int open(uint32_t type, uint64_t config, int group, bool user) noexcept {
+        struct ::perf_event_attr attr;
+        ::std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = group < 0; // Group members follow their leader
+        attr.exclude_kernel = user;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, group, 0));
+    }
+public:
+    /** Open constructor, for the calling thread.
+     * @param enabled Whether to open the counters, all being unavailable otherwise
+    **/
+    PerfCounters(bool enabled = true) noexcept: error{0} {
+        for (auto&& fd: fds)
+            fd = -1;
+        if (!enabled)
+            return;
+        struct Spec final {
+            uint32_t type;
+            uint64_t config;
+        };
+        Spec const specs[nb_events] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES}};
+        int leader = -1; // The hardware counters are scheduled together, as one group
+        for (size_t i = 0; i < nb_events; ++i) {
+            auto hardware = specs[i].type == PERF_TYPE_HARDWARE;
+            auto fd = open(specs[i].type, specs[i].config, hardware ? leader : -1, hardware);
+            if (fd < 0 && !hardware) // Possibly not allowed to count kernel events
+                fd = open(specs[i].type, specs[i].config, -1, true);
+            if (fd < 0 && error == 0)
+                error = errno;
+            if (hardware && leader < 0)
+                leader = fd;
+            fds[i] = fd;
+        }
+    }
+    /** Close destructor.
+    **/
+    ~PerfCounters() {
+        for (auto fd: fds) {
+            if (fd >= 0)
+                ::close(fd);
+        }
+    }
+private:
+    /** Apply a counter control operation to every group leader.
+     * @param request 'PERF_EVENT_IOC_*' request
+    **/
+    void control(unsigned long request) noexcept {
+        int leader = -1;
+        for (size_t i = 0; i < nb_events; ++i) {
+            if (fds[i] < 0)
+                continue;
+            auto hardware = i != context_switches;
+            if (hardware && leader >= 0) // Member of the hardware group
+                continue;
+            if (hardware)
+                leader = fds[i];
+            ::ioctl(fds[i], request, PERF_IOC_FLAG_GROUP);
+        }
+    }
+public:
+    /** Reset and start counting.
+    **/
+    void start() noexcept {
+        control(PERF_EVENT_IOC_RESET);
+        control(PERF_EVENT_IOC_ENABLE);
+    }
+    /** Stop counting, and add the counts (scaled if the counters were multiplexed) to the totals.
+    **/
+    void stop() noexcept {
+        control(PERF_EVENT_IOC_DISABLE);
+        for (size_t i = 0; i < nb_events; ++i) {
+            Reading reading;
+            if (fds[i] < 0 || ::read(fds[i], &reading, sizeof(reading)) != sizeof(reading)) {
+                totals.values[i] = ::std::numeric_limits<double>::quiet_NaN();
+                continue;
+            }
+            if (reading.running > 0)
+                totals.values[i] += static_cast<double>(reading.value) * static_cast<double>(reading.enabled) / static_cast<double>(reading.running);
+        }
+    }
+public:
+    /** Get the totals since construction.
+     * @return Totals
+    **/
+    auto const& get_totals() const noexcept {
+        return totals;
+    }
+    /** Get the reason why a counter is unavailable.
+     * @return Explanatory string, 'nullptr' if every counter is available
+    **/
+    char const* get_error() const noexcept {
+        return error == 0 ? nullptr : ::std::strerror(error);
+    }
+};
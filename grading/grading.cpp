@@ -24,13 +24,28 @@
 // External headers
 #include <algorithm>
 #include <atomic>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
 #include <cstring>
+#include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <random>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <type_traits>
 #include <variant>
+#include <vector>
 
 // Internal headers
 #include "common.hpp"
+#include "counters.hpp"
+#include "report.hpp"
+#include "topology.hpp"
+#include "trace.hpp"
 #include "transactional.hpp"
 #include "workload.hpp"
 
@@ -71,6 +86,7 @@ public:
     **/
     void master_notify() noexcept {
         status.store(Status::Wait, ::std::memory_order_relaxed);
+        runtime.reset(); // Each step is timed on its own
         runtime.start();
     }
     /** Master trigger termination in all threads (instead of notifying).
@@ -138,20 +154,228 @@ public:
     }
 };
 
+/** Run parameters, each settable with a "--name=value" command line flag or a "GRADING_NAME" environment variable (in that order of precedence).
+**/
+class Options final {
+private:
+    ::std::map<::std::string, ::std::string> flags; // Command line flags not queried yet
+    ::std::vector<char const*> positional; // Other command line arguments
+public:
+    /** Command line constructor.
+     * @param argc Arguments count
+     * @param argv Arguments values
+    **/
+    Options(int argc, char** argv) {
+        for (auto i = 1; i < argc; ++i) {
+            ::std::string arg{argv[i]};
+            if (arg.rfind("--", 0) != 0) {
+                positional.push_back(argv[i]);
+                continue;
+            }
+            auto sep = arg.find('=');
+            if (sep == ::std::string::npos) { // Bare flag, i.e. a switch
+                flags[arg.substr(2)] = "1";
+            } else {
+                flags[arg.substr(2, sep - 2)] = arg.substr(sep + 1);
+            }
+        }
+    }
+public:
+    /** Get the positional command line arguments.
+     * @return Positional arguments, in order
+    **/
+    auto const& args() const noexcept {
+        return positional;
+    }
+    /** Get one run parameter, throw 'Exception::Parameter' if its value cannot be parsed.
+     * @param name Flag name (the environment variable name is derived from it)
+     * @param def  Default value
+     * @return Parameter value
+    **/
+    template<class Type> Type get(char const* name, Type def) {
+        ::std::string text;
+        auto flag = flags.find(name);
+        if (flag != flags.end()) {
+            text = flag->second;
+            flags.erase(flag);
+        } else {
+            ::std::string var{"GRADING_"};
+            for (auto c = name; *c; ++c)
+                var.push_back(*c == '-' ? '_' : static_cast<char>(::std::toupper(*c)));
+            auto env = ::std::getenv(var.c_str());
+            if (!env)
+                return def;
+            text = env;
+        }
+        if constexpr (::std::is_same_v<Type, bool>) { // Switches also take 'true' or 'false'
+            if (text == "true")
+                return true;
+            if (text == "false")
+                return false;
+        }
+        ::std::istringstream input{text};
+        Type res;
+        if (!(input >> res) || !input.eof())
+            throw Exception::Parameter{"invalid run parameter value (see the usage)"};
+        return res;
+    }
+    /** Check that every command line flag has been queried, throw 'Exception::Parameter' otherwise.
+    **/
+    void check_unused() const {
+        for (auto&& flag: flags)
+            ::std::cerr << "Unknown flag '--" << flag.first << "'" << ::std::endl;
+        if (unlikely(!flags.empty()))
+            throw Exception::Parameter{"unknown command line flag(s)"};
+    }
+};
+
+/** Measurements of one workload with one transactional library.
+**/
+struct Measurement final {
+    char const*  error;      // Error constant null-terminated string ('nullptr' for none)
+    Chrono::Tick time_init;  // Initialization time (in ns)
+    Chrono::Tick time_perf;  // Median execution time of the runs (in ns)
+    Chrono::Tick time_chck;  // Correctness check time (in ns)
+    double       time_mean;  // Mean execution time of the runs (in ns)
+    double       time_stddev; // Standard deviation of the execution times of the runs (in ns)
+    double       time_ci;    // Half-width of the 95% confidence interval of the mean execution time (in ns)
+    double       rate;       // Median throughput of the runs (in committed transactions per second)
+    double       rate_mean;  // Mean throughput of the runs (in committed transactions per second)
+    double       rate_stddev; // Standard deviation of the throughputs of the runs (in committed transactions per second)
+    double       rate_ci;    // Half-width of the 95% confidence interval of the mean throughput (in committed transactions per second)
+    double       cpu_time;   // Mean CPU time of the runs, summed over the workers (in ns)
+    double       abort_rate; // Ratio of the transactions begun during the runs that had to be retried
+    size_t       committed;  // Transactions committed during the runs, 0 if not tracked by the workload
+    PerfCounters::Values counters; // Performance counter totals of the runs, over every worker
+    char const*  counters_error; // Why some counters are unavailable, 'nullptr' if none is
+    ::std::vector<Chrono::Tick> times; // Execution time of each run (in ns)
+    ::std::vector<double> rates; // Throughput of each run (in committed transactions per second)
+    ::std::vector<size_t> outliers; // Indices of the runs whose throughput is an outlier
+    ::std::vector<TransactionStats> stats; // Per-type transaction statistics of the runs, merged over every worker
+    ::std::vector<::std::vector<::std::pair<::std::string, uint64_t>>> run_stats; // Library's statistics of the shared memory region after each run, empty if none
+};
+
+/** Merge per-type transaction statistics into others.
+ * @param into  Statistics to merge into (empty for none yet)
+ * @param stats Statistics to merge in, of the same types in the same order
+**/
+static void merge_stats(::std::vector<TransactionStats>& into, ::std::vector<TransactionStats> const& stats) {
+    if (into.empty()) {
+        into = stats;
+        return;
+    }
+    for (size_t i = 0; i < into.size() && i < stats.size(); ++i)
+        into[i].merge(stats[i]);
+}
+
+/** Compute the mean and the (sample) standard deviation of the given values.
+ * @param values Values
+ * @param count  Number of values
+ * @return Mean, standard deviation
+**/
+template<class Type> static auto mean_stddev(Type const* values, size_t count) {
+    double sum = 0.;
+    for (size_t i = 0; i < count; ++i)
+        sum += static_cast<double>(values[i]);
+    auto mean = sum / static_cast<double>(count);
+    double var = 0.;
+    for (size_t i = 0; i < count; ++i)
+        var += (static_cast<double>(values[i]) - mean) * (static_cast<double>(values[i]) - mean);
+    return ::std::make_pair(mean, count > 1 ? ::std::sqrt(var / static_cast<double>(count - 1)) : 0.);
+}
+
+/** Get the two-sided 95% quantile of the Student's t-distribution.
+ * @param dof Degrees of freedom (positive)
+ * @return Quantile
+**/
+static double student95(size_t dof) {
+    constexpr static double table[] = {12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228, 2.201, 2.179, 2.160, 2.145, 2.131,
+        2.120, 2.110, 2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+    if (dof <= sizeof(table) / sizeof(*table))
+        return table[dof - 1];
+    return 1.960 + 2.372 / static_cast<double>(dof); // Cornish-Fisher expansion, within 0.1 % past 30
+}
+
+/** Compute the half-width of the 95% confidence interval of the mean of the given values.
+ * @param stddev Standard deviation of the values
+ * @param count  Number of values
+ * @return Half-width, 0 with less than 2 values
+**/
+static double confidence95(double stddev, size_t count) {
+    if (count < 2)
+        return 0.;
+    return student95(count - 1) * stddev / ::std::sqrt(static_cast<double>(count));
+}
+
+/** Find the outliers of the given values, i.e. the ones past Tukey's fences (1.5 interquartile range beyond the quartiles).
+ * @param values Values
+ * @return Indices of the outliers
+**/
+template<class Type> static auto outliers_of(::std::vector<Type> const& values) {
+    ::std::vector<size_t> res;
+    if (values.size() < 4)
+        return res;
+    auto sorted = values;
+    ::std::sort(sorted.begin(), sorted.end());
+    auto quartile = [&](double ratio) { // Linear interpolation between the closest ranks
+        auto pos = ratio * static_cast<double>(sorted.size() - 1);
+        auto low = static_cast<size_t>(pos);
+        auto high = ::std::min(low + 1, sorted.size() - 1);
+        return static_cast<double>(sorted[low]) + (pos - static_cast<double>(low)) * (static_cast<double>(sorted[high]) - static_cast<double>(sorted[low]));
+    };
+    auto q1 = quartile(0.25);
+    auto q3 = quartile(0.75);
+    for (size_t i = 0; i < values.size(); ++i) {
+        auto value = static_cast<double>(values[i]);
+        if (value < q1 - 1.5 * (q3 - q1) || value > q3 + 1.5 * (q3 - q1))
+            res.push_back(i);
+    }
+    return res;
+}
+
+/** Tell whether the means of two samples differ significantly, with Welch's t-test at the 95% level.
+ * @param a First sample
+ * @param b Second sample
+ * @return Whether the difference is significant, false with less than 2 values in a sample
+**/
+template<class Type> static bool significant(::std::vector<Type> const& a, ::std::vector<Type> const& b) {
+    if (a.size() < 2 || b.size() < 2)
+        return false;
+    auto [mean_a, stddev_a] = mean_stddev(a.data(), a.size());
+    auto [mean_b, stddev_b] = mean_stddev(b.data(), b.size());
+    auto var_a = stddev_a * stddev_a / static_cast<double>(a.size());
+    auto var_b = stddev_b * stddev_b / static_cast<double>(b.size());
+    if (var_a + var_b <= 0.)
+        return mean_a != mean_b;
+    auto t = ::std::fabs(mean_a - mean_b) / ::std::sqrt(var_a + var_b);
+    auto dof = (var_a + var_b) * (var_a + var_b) / (var_a * var_a / static_cast<double>(a.size() - 1) + var_b * var_b / static_cast<double>(b.size() - 1)); // Welch-Satterthwaite
+    return t > student95(::std::max<size_t>(1, static_cast<size_t>(dof)));
+}
+
 /** Measure the arithmetic mean of the execution time of the given workload with the given transaction library.
  * @param workload     Workload instance to use
  * @param nbthreads    Number of concurrent threads to use
+ * @param nbwarmups    Number of discarded warm-up repetitions, before the measured ones
  * @param nbrepeats    Number of repetitions (keep the median)
  * @param seed         Seed to use for performance measurements
  * @param maxtick_init Timeout for (re)initialization ('Chrono::invalid_tick' for none)
  * @param maxtick_perf Timeout for performance measurements ('Chrono::invalid_tick' for none)
  * @param maxtick_chck Timeout for correctness check ('Chrono::invalid_tick' for none)
- * @return Error constant null-terminated string ('nullptr' for none), execution times (in ns) (undefined if inconsistency detected)
+ * @param cpus         CPU to pin each thread to, empty for no pinning
+ * @param counters     Whether to count hardware events during the runs
+ * @return Measurements (undefined if inconsistency detected)
 **/
-static auto measure(Workload& workload, unsigned int const nbthreads, unsigned int const nbrepeats, Seed seed, Chrono::Tick maxtick_init, Chrono::Tick maxtick_perf, Chrono::Tick maxtick_chck) {
+static Measurement measure(Workload& workload, unsigned int const nbthreads, unsigned int const nbwarmups, unsigned int const nbrepeats, Seed seed, Chrono::Tick maxtick_init, Chrono::Tick maxtick_perf, Chrono::Tick maxtick_chck, ::std::vector<unsigned int> const& cpus, bool counters) {
     ::std::vector<::std::thread> threads(nbthreads);
     ::std::mutex  cerrlock;        // To avoid interleaving writes to 'cerr' in case more than one thread throw
     Sync          sync{nbthreads}; // "As-synchronized-as-possible" starts so that threads interfere "as-much-as-possible"
+    ::std::atomic<uint_fast64_t> attempts{0}; // Transactions begun during the current run
+    ::std::atomic<uint_fast64_t> retries{0};  // Transactions retried during the current run
+    ::std::atomic<uint_fast64_t> cputime{0};  // CPU time of the workers during the current run (in ns)
+    ::std::vector<::std::vector<TransactionStats>> stats(nbthreads); // Per-worker transaction statistics of the runs
+    ::std::mutex  countlock;       // To merge the performance counters of the workers
+    PerfCounters::Values counts;   // Performance counter totals of the runs
+    char const*   counterror = nullptr; // Why some counters are unavailable
     
     // We start nbthreads threads to measure performance.
     for (unsigned int i = 0; i < nbthreads; ++i) { // Start threads
@@ -161,14 +385,39 @@ static auto measure(Workload& workload, unsigned int const nbthreads, unsigned i
                 // It is devided into a series of small tests. Each test is specified in workload.hpp.
                 // Threads are synchronized between each test so that they run with a lot of concurrency.
                 try {
+                    // 0. Placement
+                    auto pinned = cpus.empty() || Topology::pin(cpus[i]);
+                    TransactionalThread scope{workload.get_tm()};
+
                     // 1. Initialization
                     if (!sync.worker_wait()) return; // Sync. of threads
-                    sync.worker_notify(workload.init()); // Runs the test and tells the master about errors
+                    sync.worker_notify(pinned ? workload.init() : "Unable to pin a worker thread to its CPU"); // Runs the test and tells the master about errors
 
                     // 2. Performance measurements
-                    for (unsigned int count = 0; count < nbrepeats; ++count) {
+                    PerfCounters local_counters{counters};
+                    for (unsigned int count = 0; count < nbwarmups + nbrepeats; ++count) {
                         if (!sync.worker_wait()) return;
-                        sync.worker_notify(workload.run(i, seed + nbthreads * count + i));
+                        auto before = transaction_counters;
+                        auto cpu_start = Chrono::get_thread_time();
+                        if (count >= nbwarmups)
+                            local_counters.start();
+                        auto error = workload.run(i, seed + nbthreads * count + i);
+                        if (count >= nbwarmups)
+                            local_counters.stop();
+                        cputime.fetch_add(Chrono::get_thread_time() - cpu_start, ::std::memory_order_relaxed);
+                        if (count + 1 == nbwarmups + nbrepeats) { // Merged before the master is notified of the last run
+                            ::std::unique_lock<decltype(countlock)> guard{countlock};
+                            counts.merge(local_counters.get_totals());
+                            if (!counterror)
+                                counterror = local_counters.get_error();
+                        }
+                        auto local = workload.take_stats(i);
+                        if (count >= nbwarmups) { // Warm-up runs are not part of any measurement
+                            attempts.fetch_add(transaction_counters.attempts - before.attempts, ::std::memory_order_relaxed);
+                            retries.fetch_add(transaction_counters.retries - before.retries, ::std::memory_order_relaxed);
+                            merge_stats(stats[i], local);
+                        }
+                        sync.worker_notify(error);
                     }
 
                     // 3. Correctness check
@@ -199,47 +448,74 @@ static auto measure(Workload& workload, unsigned int const nbthreads, unsigned i
     // After all tests succeed, it returns the time it took to run each test.
     // It returns early in case of a failure.
     try {
-        char const* error = nullptr;
-        Chrono::Tick time_init = Chrono::invalid_tick;
-        Chrono::Tick times[nbrepeats];
-        Chrono::Tick time_chck = Chrono::invalid_tick;
+        Measurement res{nullptr, Chrono::invalid_tick, Chrono::invalid_tick, Chrono::invalid_tick, 0., 0., 0., 0., 0., 0., 0., 0., 0., 0, {}, nullptr, {}, {}, {}, {}, {}};
+        auto& error = res.error;
+        auto& times = res.times;
+        auto& rates = res.rates;
         auto const posmedian = nbrepeats / 2;
         { // Initialization (with cheap correctness test)
             sync.master_notify(); // We tell workers to start working.
-            auto res = sync.master_wait(maxtick_init); // If running the student's version, it will timeout if way slower than the reference.
-            if (unlikely(::std::holds_alternative<char const*>(res))) { // If an error happened (timeout or violation), we return early!
-                error = ::std::get<char const*>(res);
+            auto run = sync.master_wait(maxtick_init); // If running the student's version, it will timeout if way slower than the reference.
+            if (unlikely(::std::holds_alternative<char const*>(run))) { // If an error happened (timeout or violation), we return early!
+                error = ::std::get<char const*>(run);
                 goto join;
             }
-            time_init = ::std::get<Chrono>(res).get_tick();
+            res.time_init = ::std::get<Chrono>(run).get_tick();
         }
         { // Performance measurements (with cheap correctness tests)
-            for (unsigned int i = 0; i < nbrepeats; ++i) {
+            for (unsigned int i = 0; i < nbwarmups + nbrepeats; ++i) {
                 sync.master_notify();
-                auto res = sync.master_wait(maxtick_perf);
-                if (unlikely(::std::holds_alternative<char const*>(res))) {
-                    error = ::std::get<char const*>(res);
+                auto run = sync.master_wait(maxtick_perf);
+                if (unlikely(::std::holds_alternative<char const*>(run))) {
+                    error = ::std::get<char const*>(run);
                     goto join;
                 }
-                times[i] = ::std::get<Chrono>(res).get_tick();
+                auto time = ::std::get<Chrono>(run).get_tick();
+                auto committed = workload.take_committed();
+                auto cpu = cputime.exchange(0, ::std::memory_order_relaxed);
+                if (i < nbwarmups) // Discarded warm-up run
+                    continue;
+                times.push_back(time);
+                res.committed += committed;
+                rates.push_back(static_cast<double>(committed) * 1000000000. / static_cast<double>(time));
+                if (auto stats = workload.get_tm().get_stats(); !stats.empty()) // E.g. to see in which runs the library changed its behavior
+                    res.run_stats.push_back(::std::move(stats));
+                res.cpu_time += static_cast<double>(cpu) / static_cast<double>(nbrepeats);
             }
-            ::std::nth_element(times, times + posmedian, times + nbrepeats); // Partition times around the median
+            ::std::tie(res.time_mean, res.time_stddev) = mean_stddev(times.data(), nbrepeats);
+            ::std::tie(res.rate_mean, res.rate_stddev) = mean_stddev(rates.data(), nbrepeats);
+            res.time_ci = confidence95(res.time_stddev, nbrepeats);
+            res.rate_ci = confidence95(res.rate_stddev, nbrepeats);
+            res.outliers = outliers_of(rates); // The same runs as by execution time, unless runs have a fixed duration
+            auto nbattempts = attempts.load(::std::memory_order_relaxed);
+            res.abort_rate = nbattempts > 0 ? static_cast<double>(retries.load(::std::memory_order_relaxed)) / static_cast<double>(nbattempts) : 0.;
+            auto sorted_times = times;
+            auto sorted_rates = rates;
+            ::std::nth_element(sorted_times.begin(), sorted_times.begin() + posmedian, sorted_times.end()); // Partition times around the median
+            ::std::nth_element(sorted_rates.begin(), sorted_rates.begin() + posmedian, sorted_rates.end());
+            res.time_perf = sorted_times[posmedian];
+            res.rate = sorted_rates[posmedian];
+            for (auto&& local: stats) // Workers are done with their runs
+                merge_stats(res.stats, local);
+            res.counters = counts;
+            res.counters_error = counterror;
         }
         { // Correctness check
+            workload.take_committed(); // Not part of any measurement
             sync.master_notify();
-            auto res = sync.master_wait(maxtick_chck);
-            if (unlikely(::std::holds_alternative<char const*>(res))) {
-                error = ::std::get<char const*>(res);
+            auto run = sync.master_wait(maxtick_chck);
+            if (unlikely(::std::holds_alternative<char const*>(run))) {
+                error = ::std::get<char const*>(run);
                 goto join;
             }
-            time_chck = ::std::get<Chrono>(res).get_tick();
+            res.time_chck = ::std::get<Chrono>(run).get_tick();
         }
         join: { // Joining
             sync.master_join(); // Join with threads
             for (unsigned int i = 0; i < nbthreads; ++i)
                 threads[i].join();
         }
-        return ::std::make_tuple(error, time_init, times[posmedian], time_chck);
+        return res;
     } catch (...) {
         for (unsigned int i = 0; i < nbthreads; ++i) // Detach threads to avoid termination due to attached thread going out of scope
             threads[i].detach();
@@ -249,6 +525,522 @@ static auto measure(Workload& workload, unsigned int const nbthreads, unsigned i
 
 // -------------------------------------------------------------------------- //
 
+/** Workload run parameters, for a given number of worker threads.
+**/
+struct Parameters final {
+    ::std::string workload; // Workload name
+    size_t nbtxperwrk;    // Number of transactions per worker
+    size_t nbaccounts;    // Initial number of accounts
+    size_t expnbaccounts; // Expected number of accounts
+    WorkloadBank::Balance init_balance; // Initial account balance
+    float prob_long;      // Long transaction probability
+    float prob_alloc;     // Allocation transaction probability
+    bool batched;         // Whether the bank workload scans and initializes its accounts with range accesses
+    size_t key_range;     // Key range of the integer set workloads
+    float update_ratio;   // Update probability of the integer set workloads
+    float initial_fill;   // Initial fill ratio of the integer set workloads
+    size_t nbrecords;     // Initial number of records of the key-value workload
+    size_t maxrecords;    // Maximal number of records of the key-value workload
+    size_t nbfields;      // Number of fields per record of the key-value workload
+    char ycsb;            // YCSB core workload letter of the key-value workload
+    double zipf;          // Zipfian skew of the key-value workload
+    unsigned int nbwarmups; // Number of discarded warm-up runs
+    unsigned int nbrepeats; // Number of measured runs
+    unsigned long slow_factor; // Timeout factor, relative to the reference
+    Chrono::Tick duration; // Duration of a run (in ns), 0 to run all the transactions
+    Seed seed;            // Seed value
+    ::std::string record; // Trace file of the reference library's runs, empty for none
+    ::std::string placement; // Worker placement policy
+    ::std::vector<unsigned int> cpus; // CPU of each worker thread, empty if not pinned
+    bool counters;        // Whether to count hardware events during the runs
+    ::std::string retry;  // Retry policy of the aborted transactions
+    size_t retry_bound;   // Bound of the retry policy
+    ::std::string durable; // File backing the durable regions of the extra durable runs, empty for none
+    long durable_latency_us; // Longest wait for concurrent commits to share a sync in the durable runs (in µs)
+    size_t durable_capacity; // Size of the file backing the durable regions (in bytes), 0 for the library's default
+};
+
+/** Evaluation of one library for one number of worker threads.
+**/
+struct Evaluation final {
+    char const* library;  // Library path
+    size_t nbworkers;     // Number of worker threads
+    size_t nbtxperwrk;    // Number of transactions per worker
+    bool reference;       // Whether this is the reference library
+    ::std::string placement; // Worker placement policy
+    ::std::vector<unsigned int> cpus; // CPU of each worker thread, empty if not pinned
+    Measurement measure;  // Measurements
+    double speedup;       // Speedup relative to the reference (1 for the reference)
+    bool significant;     // Whether the difference from the reference is significant at the 95% level (false for the reference)
+    ::std::vector<::std::pair<::std::string, uint64_t>> library_stats; // Library's statistics of the shared memory region, after the runs
+    double durable_rate;  // Throughput of the same runs over a durable region (in committed transactions per second), 0 if not measured
+};
+
+/** Format the CPUs of the worker threads.
+ * @param cpus CPU of each worker thread, empty if not pinned
+ * @param sep  Separator between CPUs
+ * @return Formatted CPUs, empty if not pinned
+**/
+static ::std::string format_cpus(::std::vector<unsigned int> const& cpus, char const* sep) {
+    ::std::ostringstream res;
+    for (size_t i = 0; i < cpus.size(); ++i)
+        res << (i > 0 ? sep : "") << cpus[i];
+    return res.str();
+}
+
+/** Print the library's statistics of a shared memory region on one line, unless there is none.
+ * @param label Line label
+ * @param stats Named statistics
+**/
+static void print_library_stats(::std::string const& label, ::std::vector<::std::pair<::std::string, uint64_t>> const& stats) {
+    if (stats.empty())
+        return;
+    ::std::cout << "⎪ " << label << ":";
+    for (size_t i = 0; i < stats.size(); ++i)
+        ::std::cout << (i > 0 ? ", " : " ") << stats[i].first << " " << stats[i].second;
+    ::std::cout << ::std::endl;
+}
+
+/** Format one performance counter total per committed transaction.
+ * @param output    Stream to write to
+ * @param value     Counter total, NaN if unavailable
+ * @param committed Number of committed transactions
+ * @param none      What to write if the counter is unavailable
+**/
+static void format_per_tx(::std::ostream& output, double value, size_t committed, char const* none) {
+    if (::std::isnan(value) || committed == 0) {
+        output << none;
+    } else {
+        output << value / static_cast<double>(committed);
+    }
+}
+
+/** Build the workload selected by the run parameters.
+ * @param tl        Transactional library to use
+ * @param nbworkers Number of worker threads
+ * @param params    Run parameters
+ * @return Built workload
+**/
+static ::std::unique_ptr<Workload> make_workload(TransactionalLibrary const& tl, size_t nbworkers, Parameters const& params) {
+    if (params.workload == "bank")
+        return ::std::make_unique<WorkloadBank>(tl, nbworkers, params.nbtxperwrk, params.nbaccounts, params.expnbaccounts, params.init_balance, params.prob_long, params.prob_alloc, params.duration, params.batched);
+    if (params.workload == "list")
+        return ::std::make_unique<WorkloadList>(tl, nbworkers, params.nbtxperwrk, params.key_range, params.update_ratio, params.initial_fill, params.duration);
+    if (params.workload == "skiplist")
+        return ::std::make_unique<WorkloadSkipList>(tl, nbworkers, params.nbtxperwrk, params.key_range, params.update_ratio, params.initial_fill, params.duration);
+    if (params.workload == "hashset")
+        return ::std::make_unique<WorkloadHashSet>(tl, nbworkers, params.nbtxperwrk, params.key_range, params.update_ratio, params.initial_fill, params.duration);
+    if (params.workload == "rbtree")
+        return ::std::make_unique<WorkloadRBTree>(tl, nbworkers, params.nbtxperwrk, params.key_range, params.update_ratio, params.initial_fill, params.duration);
+    if (params.workload == "kv")
+        return ::std::make_unique<WorkloadKV>(tl, nbworkers, params.nbtxperwrk, params.nbrecords, params.maxrecords, params.nbfields, WorkloadKV::mix_of(params.ycsb), params.zipf, params.duration);
+    if (params.workload == "vacation")
+        return ::std::make_unique<WorkloadVacation>(tl, nbworkers, params.nbtxperwrk, 4096, params.duration);
+    if (params.workload == "kmeans")
+        return ::std::make_unique<WorkloadKMeans>(tl, nbworkers, params.nbtxperwrk, params.duration);
+    if (params.workload == "genome")
+        return ::std::make_unique<WorkloadGenome>(tl, nbworkers, params.nbtxperwrk);
+    throw Exception::Parameter{"unknown workload"};
+}
+
+/** Record the operations of one run of the workload to a trace, in a pass of its own so that no measurement pays for the recording.
+ * Only the run is recorded: the initialization comes before and the check is skipped.
+ * @param tl        Transactional library to use
+ * @param nbworkers Number of worker threads
+ * @param params    Run parameters
+ * @return Constant null-terminated error message, 'nullptr' for none
+**/
+static char const* record_trace(TransactionalLibrary const& tl, size_t nbworkers, Parameters const& params) {
+    auto workload = make_workload(tl, nbworkers, params);
+    ::std::unique_ptr<TraceRecorder> recorder;
+    ::std::vector<char const*> errors(nbworkers, nullptr);
+    ::std::vector<::std::thread> threads;
+    Barrier barrier{static_cast<Barrier::Counter>(nbworkers + 1)};
+    for (size_t i = 0; i < nbworkers; ++i) {
+        threads.emplace_back([&](size_t i) {
+            try {
+                if (!params.cpus.empty() && !Topology::pin(params.cpus[i]))
+                    errors[i] = "Unable to pin a worker thread to its CPU";
+                TransactionalThread scope{workload->get_tm()};
+                if (!errors[i])
+                    errors[i] = workload->init();
+                barrier.sync(); // Initialized, the recorder is then attached
+                barrier.sync();
+                if (!errors[i]) // Same seeds as the first run of 'measure'
+                    errors[i] = workload->run(static_cast<Uid>(i), params.seed + i);
+            } catch (::std::exception const& err) {
+                errors[i] = "Internal worker exception(s)";
+            }
+        }, i);
+    }
+    barrier.sync();
+    recorder = ::std::make_unique<TraceRecorder>(workload->get_tm());
+    barrier.sync();
+    for (auto&& thread: threads)
+        thread.join();
+    for (auto error: errors) {
+        if (error)
+            return error;
+    }
+    recorder->save(params.record.c_str());
+    return nullptr;
+}
+
+/** Evaluate every library with the given number of worker threads, the first one being the reference.
+ * @param libraries Library paths
+ * @param nbworkers Number of worker threads
+ * @param params    Run parameters
+ * @param results   Evaluations to append to
+ * @return Whether every library passed the correctness checks
+**/
+static bool evaluate(::std::vector<char const*> const& libraries, size_t nbworkers, Parameters const& params, ::std::vector<Evaluation>& results) {
+    double reference = 0.; // Set to avoid irrelevant '-Wmaybe-uninitialized'
+    double reference_rate = 0.;
+    ::std::vector<Chrono::Tick> reference_times; // Reference execution time of each run
+    ::std::vector<double> reference_rates;       // Reference throughput of each run
+    auto const pertxdiv = static_cast<double>(nbworkers) * static_cast<double>(params.nbtxperwrk);
+    auto maxtick_init = Chrono::invalid_tick;
+    auto maxtick_perf = Chrono::invalid_tick;
+    auto maxtick_chck = Chrono::invalid_tick;
+    for (auto library: libraries) {
+        ::std::cout << "⎧ Evaluating '" << library << "'" << (maxtick_init == Chrono::invalid_tick ? " (reference)" : "") << " with " << nbworkers << " worker thread(s)..." << ::std::endl;
+        if (!params.cpus.empty())
+            ::std::cout << "⎪ Worker CPUs: " << format_cpus(params.cpus, " ") << ::std::endl;
+        // Load TM library
+        TransactionalLibrary tl{library};
+        auto extensions = tl.get_extensions();
+        if (!extensions.empty())
+            ::std::cout << "⎪ Library extensions: " << extensions << ::std::endl;
+        // Initialize workload (shared memory lifetime bound to workload: created and destroyed at the same time)
+        auto workload = make_workload(tl, nbworkers, params);
+        try {
+            // Actual performance measurements and correctness check
+            auto res = measure(*workload, nbworkers, params.nbwarmups, params.nbrepeats, params.seed, maxtick_init, maxtick_perf, maxtick_chck, params.cpus, params.counters);
+            // Check false negative-free correctness
+            if (unlikely(res.error)) {
+                ::std::cout << "⎩ " << res.error << ::std::endl;
+                return false;
+            }
+            if (maxtick_init == Chrono::invalid_tick && !params.record.empty()) { // Unmeasured recording pass of the reference
+                if (auto error = record_trace(tl, nbworkers, params); unlikely(error)) {
+                    ::std::cout << "⎩ Recording: " << error << ::std::endl;
+                    return false;
+                }
+                ::std::cout << "⎪ Trace recorded to '" << params.record << "'" << ::std::endl;
+            }
+            // Print results
+            auto perfdbl = static_cast<double>(res.time_perf);
+            auto is_reference = maxtick_init == Chrono::invalid_tick;
+            double speedup = 1.;
+            bool is_significant = false;
+            auto print_significance = [&]() {
+                ::std::cout << " (" << (is_significant ? "" : "not ") << "significant at 95%)";
+            };
+            if (params.duration > 0) { // Fixed-duration run: the throughput is what matters
+                ::std::cout << "⎪ Throughput: " << res.rate << " TX/s";
+                if (is_reference) {
+                    reference_rate = res.rate;
+                    reference_rates = res.rates;
+                } else {
+                    speedup = res.rate / reference_rate;
+                    is_significant = significant(res.rates, reference_rates);
+                    ::std::cout << " -> " << speedup << " speedup";
+                    print_significance();
+                }
+                ::std::cout << ::std::endl;
+            }
+            ::std::cout << "⎪ Total user execution time: " << (perfdbl / 1000000.) << " ms";
+            if (is_reference) { // Set reference performance
+                maxtick_init = params.slow_factor * res.time_init;
+                if (unlikely(maxtick_init == Chrono::invalid_tick)) // Bad luck...
+                    ++maxtick_init;
+                maxtick_perf = params.slow_factor * res.time_perf;
+                if (unlikely(maxtick_perf == Chrono::invalid_tick)) // Bad luck...
+                    ++maxtick_perf;
+                maxtick_chck = params.slow_factor * res.time_chck;
+                if (unlikely(maxtick_chck == Chrono::invalid_tick)) // Bad luck...
+                    ++maxtick_chck;
+                reference = perfdbl;
+                reference_times = res.times;
+            } else if (params.duration == 0) { // Compare with reference performance
+                speedup = reference / perfdbl;
+                is_significant = significant(res.times, reference_times);
+                ::std::cout << " -> " << speedup << " speedup";
+                print_significance();
+            }
+            ::std::cout << ::std::endl;
+            if (params.duration > 0) {
+                ::std::cout << "⎪ Run throughputs: mean " << res.rate_mean << " ± " << res.rate_ci << " TX/s (95% CI), median " << res.rate << " TX/s, stddev " << res.rate_stddev << " TX/s" << ::std::endl;
+            } else {
+                ::std::cout << "⎪ Run times: mean " << (res.time_mean / 1000000.) << " ± " << (res.time_ci / 1000000.) << " ms (95% CI), median " << (perfdbl / 1000000.) << " ms, stddev " << (res.time_stddev / 1000000.) << " ms" << ::std::endl;
+            }
+            ::std::cout << "⎪ Worker CPU time: " << (res.cpu_time / 1000000.) << " ms per run (" << (100. * res.cpu_time / (res.time_mean * static_cast<double>(nbworkers))) << " % of the workers' wall time)" << ::std::endl;
+            if (!res.outliers.empty()) {
+                ::std::cout << "⎪ Outlier run(s):";
+                for (auto i: res.outliers) {
+                    if (params.duration > 0) {
+                        ::std::cout << " #" << (i + 1) << " (" << res.rates[i] << " TX/s)";
+                    } else {
+                        ::std::cout << " #" << (i + 1) << " (" << (static_cast<double>(res.times[i]) / 1000000.) << " ms)";
+                    }
+                }
+                ::std::cout << ::std::endl;
+            }
+            ::std::cout << "⎪ Abort rate: " << (100. * res.abort_rate) << " %" << ::std::endl;
+            if (res.committed == 0) // Not tracked by the workload, which then commits all its transactions
+                res.committed = static_cast<size_t>(pertxdiv) * params.nbrepeats;
+            auto throughput_of = [&](Measurement const& measure) { // Mean over the runs, whether they have a fixed duration or not
+                return static_cast<double>(measure.committed) * 1000000000. / (measure.time_mean * static_cast<double>(params.nbrepeats));
+            };
+            if (res.counters.none()) {
+                if (params.counters)
+                    ::std::cout << "⎪ Hardware counters: unavailable (" << (res.counters_error ? res.counters_error : "unknown error") << ")" << ::std::endl;
+            } else {
+                ::std::cout << "⎪ Per committed TX:";
+                for (size_t i = 0; i < PerfCounters::nb_events; ++i) {
+                    ::std::cout << (i > 0 ? ", " : " ");
+                    format_per_tx(::std::cout, res.counters.values[i], res.committed, "n/a");
+                    ::std::cout << " " << PerfCounters::names[i];
+                }
+                auto ipc = res.counters.values[PerfCounters::instructions] / res.counters.values[PerfCounters::cycles];
+                if (!::std::isnan(ipc))
+                    ::std::cout << " (" << ipc << " IPC)";
+                ::std::cout << ::std::endl;
+                if (res.counters_error)
+                    ::std::cout << "⎪ Some hardware counters are unavailable (" << res.counters_error << ")" << ::std::endl;
+            }
+            for (size_t i = 0; i < res.run_stats.size(); ++i)
+                print_library_stats("Library statistics after run #" + ::std::to_string(i + 1), res.run_stats[i]);
+            auto library_stats = workload->get_tm().get_stats();
+            print_library_stats("Library statistics", library_stats);
+            for (auto&& stats: res.stats) {
+                if (stats.latency.get_count() == 0)
+                    continue;
+                ::std::cout << "⎪ " << stats.name << " TX latency: p50 " << stats.latency.get_percentile(0.5) << " ns, p99 " << stats.latency.get_percentile(0.99)
+                    << " ns, p999 " << stats.latency.get_percentile(0.999) << " ns, max " << stats.latency.get_max() << " ns; retries: p50 " << stats.retries.get_percentile(0.5)
+                    << ", p99 " << stats.retries.get_percentile(0.99) << ", max " << stats.retries.get_max() << ::std::endl;
+            }
+            double durable_rate = 0.;
+            if (!params.durable.empty() && !tl.has_durable()) {
+                ::std::cout << "⎪ Durable throughput: n/a (no durable regions in this library)" << ::std::endl;
+            } else if (!params.durable.empty()) { // Same runs over a durable region, unbounded since every commit now waits for a sync
+                tl.set_durable(TransactionalLibrary::Durable{params.durable, params.durable_latency_us, params.durable_capacity});
+                auto durable_workload = make_workload(tl, nbworkers, params);
+                tl.set_durable(TransactionalLibrary::Durable{"", 0, 0});
+                auto durable_res = measure(*durable_workload, nbworkers, params.nbwarmups, params.nbrepeats, params.seed, Chrono::invalid_tick, Chrono::invalid_tick, Chrono::invalid_tick, params.cpus, false);
+                if (unlikely(durable_res.error)) {
+                    ::std::cout << "⎩ Durable runs: " << durable_res.error << ::std::endl;
+                    return false;
+                }
+                if (durable_res.committed == 0)
+                    durable_res.committed = static_cast<size_t>(pertxdiv) * params.nbrepeats;
+                durable_rate = throughput_of(durable_res);
+                ::std::cout << "⎪ Durable throughput: " << durable_rate << " TX/s (" << (100. * durable_rate / throughput_of(res)) << " % of the volatile " << throughput_of(res) << " TX/s)" << ::std::endl;
+                print_library_stats("Durable library statistics", durable_workload->get_tm().get_stats());
+            }
+            if (params.duration > 0) {
+                ::std::cout << "⎩ Average TX execution time: " << (1000000000. * static_cast<double>(nbworkers) / res.rate) << " ns" << ::std::endl;
+            } else {
+                ::std::cout << "⎩ Average TX execution time: " << (perfdbl / pertxdiv) << " ns" << ::std::endl;
+            }
+            results.push_back(Evaluation{library, nbworkers, params.nbtxperwrk, is_reference, params.placement, params.cpus, res, speedup, is_significant, ::std::move(library_stats), durable_rate});
+        } catch (::std::exception const& err) { // Special case: cannot unload library with running threads, so print error and quick-exit
+            ::std::cerr << "⎪ *** EXCEPTION ***" << ::std::endl;
+            ::std::cerr << "⎩ " << err.what() << ::std::endl;
+            ::std::quick_exit(2);
+        }
+    }
+    return true;
+}
+
+/** Write the run parameters, as a JSON object.
+ * @param output Output stream
+ * @param params Run parameters, the ones depending on the number of worker threads being those of '--workers'
+ * @param sweep  Whether the evaluations are a thread-count sweep
+**/
+static void write_parameters(::std::ostream& output, Parameters const& params, bool sweep) {
+    output << "{\"workload\": " << json_quote(params.workload) << ", \"sweep\": " << (sweep ? "true" : "false")
+        << ", \"tx_per_worker\": " << params.nbtxperwrk << ", \"accounts\": " << params.nbaccounts << ", \"expected_accounts\": " << params.expnbaccounts
+        << ", \"init_balance\": " << params.init_balance << ", \"prob_long\": " << params.prob_long << ", \"prob_alloc\": " << params.prob_alloc << ", \"batched\": " << (params.batched ? "true" : "false")
+        << ", \"key_range\": " << params.key_range << ", \"update_ratio\": " << params.update_ratio << ", \"initial_fill\": " << params.initial_fill
+        << ", \"records\": " << params.nbrecords << ", \"max_records\": " << params.maxrecords << ", \"fields\": " << params.nbfields
+        << ", \"ycsb\": " << json_quote(::std::string(1, params.ycsb)) << ", \"zipf\": " << params.zipf << ", \"warmups\": " << params.nbwarmups
+        << ", \"repeats\": " << params.nbrepeats << ", \"slow_factor\": " << params.slow_factor << ", \"duration_ns\": " << params.duration
+        << ", \"seed\": " << params.seed << ", \"placement\": " << json_quote(params.placement) << ", \"counters\": " << (params.counters ? "true" : "false")
+        << ", \"retry\": " << json_quote(params.retry) << ", \"retry_bound\": " << params.retry_bound << ", \"durable\": " << json_quote(params.durable)
+        << ", \"durable_latency_us\": " << params.durable_latency_us << ", \"durable_capacity\": " << params.durable_capacity << "}";
+}
+
+/** Write the evaluations in a machine-readable format.
+ * @param output  Output stream
+ * @param format  Either "csv" or "json"
+ * @param params  Run parameters, the ones depending on the number of worker threads being those of '--workers'
+ * @param sweep   Whether the evaluations are a thread-count sweep
+ * @param results Evaluations to write
+**/
+static void report(::std::ostream& output, ::std::string const& format, Parameters const& params, bool sweep, ::std::vector<Evaluation> const& results) {
+    if (format == "csv") {
+        output << "workers,library,reference,time_ns,time_mean_ns,time_stddev_ns,throughput_tx_s,throughput_stddev_tx_s,speedup,significant,abort_rate,time_ci95_ns,throughput_mean_tx_s,throughput_ci95_tx_s,cpu_time_ns,outliers,placement,cpus,instructions_per_tx,cycles_per_tx,llc_misses_per_tx,branch_misses_per_tx,context_switches_per_tx,time_init_ns,time_check_ns,tx_per_worker,durable_throughput_tx_s" << ::std::endl;
+        for (auto&& res: results) {
+            output << res.nbworkers << "," << json_quote(res.library) << "," << (res.reference ? 1 : 0) << "," << res.measure.time_perf << "," << res.measure.time_mean << "," << res.measure.time_stddev << "," << res.measure.rate << "," << res.measure.rate_stddev << "," << res.speedup << "," << (res.significant ? 1 : 0) << "," << res.measure.abort_rate << "," << res.measure.time_ci << "," << res.measure.rate_mean << "," << res.measure.rate_ci << "," << res.measure.cpu_time << "," << res.measure.outliers.size() << "," << json_quote(res.placement) << ",\"" << format_cpus(res.cpus, " ") << "\"";
+            for (auto value: res.measure.counters.values) {
+                output << ",";
+                format_per_tx(output, value, res.measure.committed, "");
+            }
+            output << "," << res.measure.time_init << "," << res.measure.time_chck << "," << res.nbtxperwrk << ",";
+            if (res.durable_rate > 0.)
+                output << res.durable_rate;
+            output << ::std::endl;
+        }
+        return;
+    }
+    output << "{" << ::std::endl;
+    output << "  \"parameters\": ";
+    write_parameters(output, params, sweep);
+    output << "," << ::std::endl;
+    output << "  \"environment\": ";
+    write_environment(output);
+    output << "," << ::std::endl;
+    output << "  \"results\": [" << ::std::endl;
+    for (size_t i = 0; i < results.size(); ++i) {
+        auto&& res = results[i];
+        output << "    {\"workers\": " << res.nbworkers << ", \"library\": " << json_quote(res.library) << ", \"reference\": " << (res.reference ? "true" : "false")
+            << ", \"tx_per_worker\": " << res.nbtxperwrk << ", \"time_init_ns\": " << res.measure.time_init << ", \"time_check_ns\": " << res.measure.time_chck
+            << ", \"time_ns\": " << res.measure.time_perf << ", \"time_mean_ns\": " << res.measure.time_mean << ", \"time_stddev_ns\": " << res.measure.time_stddev
+            << ", \"throughput_tx_s\": " << res.measure.rate << ", \"throughput_stddev_tx_s\": " << res.measure.rate_stddev
+            << ", \"speedup\": " << res.speedup << ", \"significant\": " << (res.significant ? "true" : "false") << ", \"abort_rate\": " << res.measure.abort_rate
+            << ", \"time_ci95_ns\": " << res.measure.time_ci << ", \"throughput_mean_tx_s\": " << res.measure.rate_mean << ", \"throughput_ci95_tx_s\": " << res.measure.rate_ci
+            << ", \"cpu_time_ns\": " << res.measure.cpu_time << ", \"outliers\": " << res.measure.outliers.size() << ", \"counters_per_tx\": {";
+        for (size_t j = 0; j < PerfCounters::nb_events; ++j) {
+            output << (j > 0 ? ", " : "") << "\"" << PerfCounters::keys[j] << "\": ";
+            format_per_tx(output, res.measure.counters.values[j], res.measure.committed, "null");
+        }
+        output << "}"
+            << ", \"placement\": " << json_quote(res.placement) << ", \"cpus\": [" << format_cpus(res.cpus, ", ") << "], \"transactions\": {";
+        for (size_t j = 0; j < res.measure.stats.size(); ++j) {
+            auto&& stats = res.measure.stats[j];
+            output << (j > 0 ? ", " : "") << json_quote(stats.name) << ": {\"count\": " << stats.latency.get_count()
+                << ", \"latency_mean_ns\": " << stats.latency.get_mean() << ", \"latency_p50_ns\": " << stats.latency.get_percentile(0.5)
+                << ", \"latency_p99_ns\": " << stats.latency.get_percentile(0.99) << ", \"latency_p999_ns\": " << stats.latency.get_percentile(0.999)
+                << ", \"latency_max_ns\": " << stats.latency.get_max() << ", \"retries_mean\": " << stats.retries.get_mean()
+                << ", \"retries_p50\": " << stats.retries.get_percentile(0.5) << ", \"retries_p99\": " << stats.retries.get_percentile(0.99)
+                << ", \"retries_max\": " << stats.retries.get_max() << "}";
+        }
+        output << "}, \"library_stats\": {";
+        for (size_t j = 0; j < res.library_stats.size(); ++j)
+            output << (j > 0 ? ", " : "") << json_quote(res.library_stats[j].first) << ": " << res.library_stats[j].second;
+        output << "}, \"library_stats_per_run\": [";
+        for (size_t j = 0; j < res.measure.run_stats.size(); ++j) {
+            auto&& stats = res.measure.run_stats[j];
+            output << (j > 0 ? ", " : "") << "{";
+            for (size_t k = 0; k < stats.size(); ++k)
+                output << (k > 0 ? ", " : "") << json_quote(stats[k].first) << ": " << stats[k].second;
+            output << "}";
+        }
+        output << "], \"durable_throughput_tx_s\": ";
+        if (res.durable_rate > 0.) {
+            output << res.durable_rate;
+        } else {
+            output << "null";
+        }
+        output << "}" << (i + 1 < results.size() ? "," : "") << ::std::endl;
+    }
+    output << "  ]" << ::std::endl;
+    output << "}" << ::std::endl;
+}
+
+/** Compare the evaluations with the ones of a baseline JSON report, by library path, number of worker threads and of transactions per worker.
+ * The baseline must have been made with the same run parameters, the number of measured runs and the slow trigger factor aside.
+ * @param path      Path of the baseline report
+ * @param threshold Largest relative throughput drop (or execution time increase, if the throughput is not tracked) not to be a regression
+ * @param params    Run parameters, the ones depending on the number of worker threads being those of '--workers'
+ * @param sweep     Whether the evaluations are a thread-count sweep
+ * @param results   Evaluations to compare
+ * @return Whether no regression was found
+**/
+static bool compare(::std::string const& path, double threshold, Parameters const& params, bool sweep, ::std::vector<Evaluation> const& results) {
+    auto baseline = Json::load(path);
+    auto const* entries = baseline.find("results");
+    if (unlikely(!entries || entries->get_type() != Json::Type::array))
+        throw Exception::ReportParse{"the baseline report has no 'results' array"};
+    ::std::cout << "⎧ Comparing with baseline '" << path << "' (regression threshold: " << (100. * threshold) << " %)..." << ::std::endl;
+    { // Same run parameters, or the comparison means nothing
+        ::std::ostringstream text;
+        write_parameters(text, params, sweep);
+        auto current = Json::parse(text.str());
+        auto const* base_params = baseline.find("parameters");
+        bool mismatch = false;
+        for (auto&& member: current.as_object()) {
+            if (member.first == "repeats" || member.first == "slow_factor") // Only affect how runs are summarized
+                continue;
+            auto const* base_value = base_params ? base_params->find(member.first.c_str()) : nullptr;
+            if (base_value && *base_value == member.second)
+                continue;
+            ::std::cout << "⎪ Parameter '" << member.first << "' differs from the baseline's" << ::std::endl;
+            mismatch = true;
+        }
+        if (mismatch) {
+            ::std::cout << "⎩ Not comparable" << ::std::endl;
+            throw Exception::ReportMismatch{};
+        }
+    }
+    bool ok = true;
+    for (auto&& res: results) {
+        ::std::cout << "⎪ '" << res.library << "' with " << res.nbworkers << " worker thread(s): ";
+        Json const* match = nullptr;
+        for (auto&& entry: entries->as_array()) {
+            auto const* library = entry.find("library");
+            auto const* workers = entry.find("workers");
+            auto const* txperwrk = entry.find("tx_per_worker");
+            if (library && workers && txperwrk && library->as_string() == res.library && workers->as_number() == static_cast<double>(res.nbworkers)
+             && txperwrk->as_number() == static_cast<double>(res.nbtxperwrk)) {
+                match = &entry;
+                break;
+            }
+        }
+        if (!match) {
+            ::std::cout << "no baseline" << ::std::endl;
+            continue;
+        }
+        auto figure = [&](char const* key) {
+            auto const* value = match->find(key);
+            return value ? value->as_number() : 0.;
+        };
+        auto base_rate = figure("throughput_tx_s");
+        auto base_time = figure("time_ns");
+        double change; // Relative change, positive being an improvement
+        bool apart;    // Whether the 95% confidence intervals of the means are disjoint, i.e. the change is above the run-to-run noise
+        if (base_rate > 0. && res.measure.rate > 0.) {
+            change = res.measure.rate / base_rate - 1.;
+            apart = res.measure.rate_mean + res.measure.rate_ci < figure("throughput_mean_tx_s") - figure("throughput_ci95_tx_s")
+                 || res.measure.rate_mean - res.measure.rate_ci > figure("throughput_mean_tx_s") + figure("throughput_ci95_tx_s");
+            ::std::cout << res.measure.rate << " TX/s vs " << base_rate << " TX/s";
+        } else if (base_time > 0.) {
+            change = base_time / static_cast<double>(res.measure.time_perf) - 1.;
+            apart = res.measure.time_mean - res.measure.time_ci > figure("time_mean_ns") + figure("time_ci95_ns")
+                 || res.measure.time_mean + res.measure.time_ci < figure("time_mean_ns") - figure("time_ci95_ns");
+            ::std::cout << (static_cast<double>(res.measure.time_perf) / 1000000.) << " ms vs " << (base_time / 1000000.) << " ms";
+        } else {
+            ::std::cout << "no baseline figure" << ::std::endl;
+            continue;
+        }
+        ::std::cout << " (" << (change >= 0. ? "+" : "") << (100. * change) << " %)";
+        if (change < -threshold) {
+            if (apart) {
+                ::std::cout << " *** REGRESSION ***";
+                ok = false;
+            } else {
+                ::std::cout << " within the run-to-run noise";
+            }
+        }
+        ::std::cout << ::std::endl;
+    }
+    ::std::cout << "⎩ " << (ok ? "No regression" : "Regression(s) found") << ::std::endl;
+    return ok;
+}
+
+// -------------------------------------------------------------------------- //
+
 /** Program entry point.
  * @param argc Arguments count
  * @param argv Arguments values
@@ -257,36 +1049,168 @@ static auto measure(Workload& workload, unsigned int const nbthreads, unsigned i
 int main(int argc, char** argv) {
     try {
         // Parse command line option(s)
-        if (argc < 3) {
-            ::std::cout << "Usage: " << (argc > 0 ? argv[0] : "grading") << " <seed> <reference library path> <tested library path>..." << ::std::endl;
+        Options options{argc, argv};
+        auto const& args = options.args();
+        if (args.size() < 3) {
+            ::std::cout << "Usage: " << (argc > 0 ? argv[0] : "grading") << " [--<parameter>=<value>]... <seed> <reference library path> <tested library path>..." << ::std::endl;
+            ::std::cout << "Parameters (or GRADING_<PARAMETER> environment variables, '-' replaced by '_'):" << ::std::endl;
+            ::std::cout << "  --workload           Workload to run: 'bank', 'list', 'skiplist', 'hashset', 'rbtree', 'kv', 'vacation', 'kmeans' or 'genome' (default: bank)" << ::std::endl;
+            ::std::cout << "  --workers            Number of worker threads (default: hardware concurrency)" << ::std::endl;
+            ::std::cout << "  --tx-per-worker      Number of transactions per worker (default: 200000 / workers)" << ::std::endl;
+            ::std::cout << "  --accounts           Initial number of accounts (default: 32 * workers)" << ::std::endl;
+            ::std::cout << "  --expected-accounts  Expected number of accounts (default: 256 * workers)" << ::std::endl;
+            ::std::cout << "  --init-balance       Initial account balance (default: 100)" << ::std::endl;
+            ::std::cout << "  --prob-long          Long transaction probability (default: 0.5)" << ::std::endl;
+            ::std::cout << "  --prob-alloc         Allocation transaction probability (default: 0.01)" << ::std::endl;
+            ::std::cout << "  --batched            Scan and initialize the bank accounts with range accesses, instead of per-account accesses (default: false)" << ::std::endl;
+            ::std::cout << "  --key-range          Key range of the integer set workloads (default: 1024)" << ::std::endl;
+            ::std::cout << "  --update-ratio       Probability of an insertion or a removal in the integer set workloads (default: 0.2)" << ::std::endl;
+            ::std::cout << "  --initial-fill       Ratio of the key range initially in the integer set workloads (default: 0.5)" << ::std::endl;
+            ::std::cout << "  --records            Initial number of records of the key-value workload (default: 10000)" << ::std::endl;
+            ::std::cout << "  --max-records        Maximal number of records of the key-value workload (default: 2 * records)" << ::std::endl;
+            ::std::cout << "  --fields             Number of 8-byte fields per record of the key-value workload (default: 10)" << ::std::endl;
+            ::std::cout << "  --ycsb               YCSB core workload of the key-value workload, from 'A' to 'F' (default: A)" << ::std::endl;
+            ::std::cout << "  --zipf               Zipfian skew of the key-value workload, in [0, 1) (default: 0.99)" << ::std::endl;
+            ::std::cout << "  --warmups            Number of discarded warm-up runs, before the measured ones (default: 0)" << ::std::endl;
+            ::std::cout << "  --repeats            Number of measured runs, the median is kept (default: 7)" << ::std::endl;
+            ::std::cout << "  --slow-factor        Timeout, relative to the reference (default: 16)" << ::std::endl;
+            ::std::cout << "  --duration           Run for that many ms and report the throughput (default: 0, run all transactions)" << ::std::endl;
+            ::std::cout << "  --sweep              Evaluate with 1, 2, 4... worker threads, up to '--sweep-max'" << ::std::endl;
+            ::std::cout << "  --sweep-max          Largest number of worker threads of a sweep (default: hardware concurrency)" << ::std::endl;
+            ::std::cout << "  --format             Machine-readable report format, 'csv' or 'json' (default: none, 'csv' when sweeping)" << ::std::endl;
+            ::std::cout << "  --output             Machine-readable report file (default: standard output)" << ::std::endl;
+            ::std::cout << "  --placement          Worker thread pinning: 'none', 'compact' (SMT siblings first), 'scatter' (one per core first) or a CPU list like '0,2,4-7' (default: none)" << ::std::endl;
+            ::std::cout << "  --retry              Wait between the attempts of an aborted transaction: 'immediate', 'backoff' (randomized exponential) or 'spin-yield' (default: immediate)" << ::std::endl;
+            ::std::cout << "  --retry-bound        Largest number of pauses ('backoff') or of immediate retries before yielding ('spin-yield') (default: 1024 or 8)" << ::std::endl;
+            ::std::cout << "  --counters           Count hardware events per committed transaction with 'perf_event_open' (default: false)" << ::std::endl;
+            ::std::cout << "  --baseline           JSON report made with the same parameters to compare with, exiting with code 3 on a throughput regression beyond the run-to-run noise (default: none)" << ::std::endl;
+            ::std::cout << "  --regression-threshold Largest relative throughput drop from the baseline that is not a regression (default: 0.05)" << ::std::endl;
+            ::std::cout << "  --durable            Also run each library supporting it over a durable region backed by that file (reset every time), and report its throughput (default: none)" << ::std::endl;
+            ::std::cout << "  --durable-latency-us Longest wait for concurrent commits to share a sync in the durable runs (default: 100)" << ::std::endl;
+            ::std::cout << "  --durable-capacity   Size in MiB of the file backing the durable regions (default: 0, the library's default)" << ::std::endl;
+            ::std::cout << "  --record             Record one extra, unmeasured run of the reference library to that trace file, for 'replay' (default: none, '.<workers>' appended when sweeping)" << ::std::endl;
             return 1;
         }
         // Get/set/compute run parameters
-        auto const nbworkers = []() {
+        auto const hardware = []() {
             auto res = ::std::thread::hardware_concurrency();
             if (unlikely(res == 0))
                 res = 16;
             return static_cast<size_t>(res);
         }();
-        auto const nbtxperwrk    = 200000ul / nbworkers;
-        auto const nbaccounts    = 32 * nbworkers;
-        auto const expnbaccounts = 256 * nbworkers;
-        auto const init_balance  = 100ul;
-        auto const prob_long     = 0.5f;
-        auto const prob_alloc    = 0.01f;
-        auto const nbrepeats     = 7;
-        auto const seed          = static_cast<Seed>(::std::stoul(argv[1]));
+        auto const workload      = options.get<::std::string>("workload", "bank");
+        auto const nbworkers     = options.get<size_t>("workers", hardware);
+        auto const nbtxperwrk    = options.get<size_t>("tx-per-worker", 0); // 0: derived from the number of workers
+        auto const nbaccounts    = options.get<size_t>("accounts", 0);
+        auto const expnbaccounts = options.get<size_t>("expected-accounts", 0);
+        auto const init_balance  = options.get<WorkloadBank::Balance>("init-balance", 100);
+        auto const prob_long     = options.get<float>("prob-long", 0.5f);
+        auto const prob_alloc    = options.get<float>("prob-alloc", 0.01f);
+        auto const batched       = options.get<bool>("batched", false);
+        auto const key_range     = options.get<size_t>("key-range", 1024);
+        auto const update_ratio  = options.get<float>("update-ratio", 0.2f);
+        auto const initial_fill  = options.get<float>("initial-fill", 0.5f);
+        auto const nbrecords     = options.get<size_t>("records", 10000);
+        auto const maxrecords    = options.get<size_t>("max-records", 2 * nbrecords);
+        auto const nbfields      = options.get<size_t>("fields", 10);
+        auto const ycsb          = static_cast<char>(::std::toupper(options.get<::std::string>("ycsb", "A")[0]));
+        auto const zipf          = options.get<double>("zipf", 0.99);
+        auto const nbwarmups     = options.get<unsigned int>("warmups", 0);
+        auto const nbrepeats     = options.get<unsigned int>("repeats", 7);
+        auto const slow_factor   = options.get<unsigned long>("slow-factor", 16ul);
+        auto const duration      = options.get<Chrono::Tick>("duration", 0) * 1000000ul;
+        auto const sweep         = options.get<bool>("sweep", false);
+        auto const sweep_max     = options.get<size_t>("sweep-max", hardware);
+        auto const format        = options.get<::std::string>("format", sweep ? "csv" : "");
+        auto const output        = options.get<::std::string>("output", "");
+        auto const record        = options.get<::std::string>("record", "");
+        auto const placement     = options.get<::std::string>("placement", "none");
+        auto const counters      = options.get<bool>("counters", false);
+        auto const retry         = options.get<::std::string>("retry", "immediate");
+        auto const retry_bound   = options.get<size_t>("retry-bound", retry == "spin-yield" ? 8 : 1024);
+        auto const durable       = options.get<::std::string>("durable", "");
+        auto const durable_latency = options.get<long>("durable-latency-us", 100);
+        auto const durable_capacity = options.get<size_t>("durable-capacity", 0) << 20;
+        auto const baseline      = options.get<::std::string>("baseline", "");
+        auto const threshold     = options.get<double>("regression-threshold", 0.05);
+        auto const seed          = static_cast<Seed>(::std::stoul(args[0]));
         auto const clk_res       = Chrono::get_resolution();
-        auto const slow_factor   = 16ul;
+        options.check_unused();
+        if (unlikely(nbworkers == 0 || sweep_max == 0 || nbrepeats == 0 || (nbaccounts > 0 && nbaccounts < 2)))
+            throw Exception::Parameter{"workers, repeats and sweep maximum must be positive, with at least 2 accounts"};
+        if (unlikely(durable_latency < 0))
+            throw Exception::Parameter{"the durable sync latency cannot be negative"};
+        if (unlikely(!format.empty() && format != "csv" && format != "json"))
+            throw Exception::Parameter{"the report format must be 'csv' or 'json'"};
+        if (unlikely(key_range == 0 || initial_fill < 0.f || initial_fill > 1.f))
+            throw Exception::Parameter{"the key range must be positive, and the initial fill ratio in [0, 1]"};
+        if (unlikely(nbrecords == 0 || maxrecords < nbrecords || nbfields == 0 || zipf < 0. || zipf >= 1.))
+            throw Exception::Parameter{"the key-value workload needs records, as many maximal records, fields, and a Zipfian skew in [0, 1)"};
+        WorkloadKV::mix_of(ycsb); // Throws on unknown YCSB workload
+        if (retry == "immediate") {
+            default_retry_policy = RetryPolicy{RetryPolicy::Kind::immediate};
+        } else if (retry == "backoff" && retry_bound > 0) {
+            default_retry_policy = RetryPolicy{RetryPolicy::Kind::backoff, retry_bound};
+        } else if (retry == "spin-yield") {
+            default_retry_policy = RetryPolicy{RetryPolicy::Kind::spin_yield, retry_bound};
+        } else {
+            throw Exception::Parameter{"the retry policy must be 'immediate', 'backoff' (with a positive bound) or 'spin-yield'"};
+        }
+        Topology const topology;
+        topology.place(placement, 1); // Throws on invalid placement
+        auto params_for = [&](size_t nbworkers) {
+            return Parameters{
+                workload,
+                nbtxperwrk > 0 ? nbtxperwrk : ::std::max(200000ul / nbworkers, 1ul),
+                nbaccounts > 0 ? nbaccounts : 32 * nbworkers,
+                expnbaccounts > 0 ? expnbaccounts : 256 * nbworkers,
+                init_balance, prob_long, prob_alloc, batched, key_range, update_ratio, initial_fill, nbrecords, maxrecords, nbfields, ycsb, zipf, nbwarmups, nbrepeats, slow_factor, duration, seed,
+                sweep && !record.empty() ? record + "." + ::std::to_string(nbworkers) : record,
+                placement, topology.place(placement, nbworkers), counters, retry, retry_bound, durable, durable_latency, durable_capacity};
+        };
         // Print run parameters
-        ::std::cout << "⎧ #worker threads:     " << nbworkers << ::std::endl;
-        ::std::cout << "⎪ #TX per worker:      " << nbtxperwrk << ::std::endl;
-        ::std::cout << "⎪ #repetitions:        " << nbrepeats << ::std::endl;
-        ::std::cout << "⎪ Initial #accounts:   " << nbaccounts << ::std::endl;
-        ::std::cout << "⎪ Expected #accounts:  " << expnbaccounts << ::std::endl;
-        ::std::cout << "⎪ Initial balance:     " << init_balance << ::std::endl;
-        ::std::cout << "⎪ Long TX probability: " << prob_long << ::std::endl;
-        ::std::cout << "⎪ Allocation TX prob.: " << prob_alloc << ::std::endl;
+        auto const params = params_for(nbworkers);
+        ::std::cout << "⎧ Workload:            " << workload << ::std::endl;
+        if (sweep) {
+            ::std::cout << "⎪ #worker threads:     1 to " << sweep_max << " (sweep)" << ::std::endl;
+        } else {
+            ::std::cout << "⎪ #worker threads:     " << nbworkers << ::std::endl;
+        }
+        if (duration > 0) {
+            ::std::cout << "⎪ Run duration:        " << (duration / 1000000ul) << " ms" << ::std::endl;
+        } else if (!sweep || nbtxperwrk > 0) {
+            ::std::cout << "⎪ #TX per worker:      " << params.nbtxperwrk << ::std::endl;
+        }
+        ::std::cout << "⎪ #repetitions:        " << nbrepeats;
+        if (nbwarmups > 0)
+            ::std::cout << " (after " << nbwarmups << " warm-up run(s))";
+        ::std::cout << ::std::endl;
+        if (workload == "bank") {
+            if (!sweep || nbaccounts > 0)
+                ::std::cout << "⎪ Initial #accounts:   " << params.nbaccounts << ::std::endl;
+            if (!sweep || expnbaccounts > 0)
+                ::std::cout << "⎪ Expected #accounts:  " << params.expnbaccounts << ::std::endl;
+            ::std::cout << "⎪ Initial balance:     " << init_balance << ::std::endl;
+            ::std::cout << "⎪ Long TX probability: " << prob_long << ::std::endl;
+            ::std::cout << "⎪ Allocation TX prob.: " << prob_alloc << ::std::endl;
+            ::std::cout << "⎪ Account accesses:    " << (batched ? "batched" : "per account") << ::std::endl;
+        } else if (workload == "kv") {
+            ::std::cout << "⎪ YCSB workload:       " << ycsb << ::std::endl;
+            ::std::cout << "⎪ #records:            " << nbrecords << " (up to " << maxrecords << ")" << ::std::endl;
+            ::std::cout << "⎪ #fields per record:  " << nbfields << ::std::endl;
+            ::std::cout << "⎪ Zipfian skew:        " << zipf << ::std::endl;
+        } else if (workload == "list" || workload == "skiplist" || workload == "hashset" || workload == "rbtree") {
+            ::std::cout << "⎪ Key range:           " << key_range << ::std::endl;
+            ::std::cout << "⎪ Update probability:  " << update_ratio << ::std::endl;
+            ::std::cout << "⎪ Initial fill ratio:  " << initial_fill << ::std::endl;
+        }
+        ::std::cout << "⎪ Worker placement:    " << placement << " (" << topology.get_nbpackages() << " package(s), " << topology.get_nbcores() << " core(s), " << topology.get_cpus().size() << " usable CPU(s))" << ::std::endl;
+        ::std::cout << "⎪ Retry policy:        " << retry;
+        if (retry != "immediate")
+            ::std::cout << " (bound " << retry_bound << ")";
+        ::std::cout << ::std::endl;
+        if (!durable.empty())
+            ::std::cout << "⎪ Durable runs:        '" << durable << "' (sync latency " << durable_latency << " µs)" << ::std::endl;
         ::std::cout << "⎪ Slow trigger factor: " << slow_factor << ::std::endl;
         ::std::cout << "⎪ Clock resolution:    ";
         if (unlikely(clk_res == Chrono::invalid_tick)) {
@@ -296,54 +1220,33 @@ int main(int argc, char** argv) {
         }
         ::std::cout << "⎩ Seed value:          " << seed << ::std::endl;
         // Library evaluations
-        double reference = 0.; // Set to avoid irrelevant '-Wmaybe-uninitialized'
-        auto const pertxdiv = static_cast<double>(nbworkers) * static_cast<double>(nbtxperwrk);
-        auto maxtick_init = Chrono::invalid_tick;
-        auto maxtick_perf = Chrono::invalid_tick;
-        auto maxtick_chck = Chrono::invalid_tick;
-        for (auto i = 2; i < argc; ++i) {
-            ::std::cout << "⎧ Evaluating '" << argv[i] << "'" << (maxtick_init == Chrono::invalid_tick ? " (reference)" : "") << "..." << ::std::endl;
-            // Load TM library
-            TransactionalLibrary tl{argv[i]};
-            // Initialize workload (shared memory lifetime bound to workload: created and destroyed at the same time)
-            WorkloadBank bank{tl, nbworkers, nbtxperwrk, nbaccounts, expnbaccounts, init_balance, prob_long, prob_alloc};
-            try {
-                // Actual performance measurements and correctness check
-                auto res = measure(bank, nbworkers, nbrepeats, seed, maxtick_init, maxtick_perf, maxtick_chck);
-                // Check false negative-free correctness
-                auto error = ::std::get<0>(res);
-                if (unlikely(error)) {
-                    ::std::cout << "⎩ " << error << ::std::endl;
+        ::std::vector<char const*> libraries{args.begin() + 1, args.end()};
+        ::std::vector<Evaluation> results;
+        if (sweep) {
+            for (size_t count = 1; ; count *= 2) {
+                count = ::std::min(count, sweep_max);
+                if (!evaluate(libraries, count, params_for(count), results))
                     return 1;
-                }
-                // Print results
-                auto tick_init = ::std::get<1>(res);
-                auto tick_perf = ::std::get<2>(res);
-                auto tick_chck = ::std::get<3>(res);
-                auto perfdbl = static_cast<double>(tick_perf);
-                ::std::cout << "⎪ Total user execution time: " << (perfdbl / 1000000.) << " ms";
-                if (maxtick_init == Chrono::invalid_tick) { // Set reference performance
-                    maxtick_init = slow_factor * tick_init;
-                    if (unlikely(maxtick_init == Chrono::invalid_tick)) // Bad luck...
-                        ++maxtick_init;
-                    maxtick_perf = slow_factor * tick_perf;
-                    if (unlikely(maxtick_perf == Chrono::invalid_tick)) // Bad luck...
-                        ++maxtick_perf;
-                    maxtick_chck = slow_factor * tick_chck;
-                    if (unlikely(maxtick_chck == Chrono::invalid_tick)) // Bad luck...
-                        ++maxtick_chck;
-                    reference = perfdbl;
-                } else { // Compare with reference performance
-                    ::std::cout << " -> " << (reference / perfdbl) << " speedup";
-                }
-                ::std::cout << ::std::endl;
-                ::std::cout << "⎩ Average TX execution time: " << (perfdbl / pertxdiv) << " ns" << ::std::endl;
-            } catch (::std::exception const& err) { // Special case: cannot unload library with running threads, so print error and quick-exit
-                ::std::cerr << "⎪ *** EXCEPTION ***" << ::std::endl;
-                ::std::cerr << "⎩ " << err.what() << ::std::endl;
-                ::std::quick_exit(2);
+                if (count == sweep_max)
+                    break;
+            }
+        } else if (!evaluate(libraries, nbworkers, params, results)) {
+            return 1;
+        }
+        // Machine-readable report
+        if (!format.empty()) {
+            if (output.empty()) {
+                report(::std::cout, format, params, sweep, results);
+            } else {
+                ::std::ofstream file{output};
+                report(file, format, params, sweep, results);
+                if (unlikely(!file))
+                    throw Exception::Parameter{"unable to write the report file"};
             }
         }
+        // Baseline regression gate
+        if (!baseline.empty() && !compare(baseline, threshold, params, sweep, results))
+            return 3;
         return 0;
     } catch (::std::exception const& err) {
         ::std::cerr << "⎧ *** EXCEPTION ***" << ::std::endl;
@@ -0,0 +1,274 @@
+/**
+ * @file   microbench.cpp
+ *
+ * @section DESCRIPTION
+ *
+ * Per-operation latency micro-benchmarks of the implementations.
+ *
+ * Each primitive is measured twice: through the exception-based operations (an abort throws
+ * 'Exception::TransactionRetry' out of the transaction body) and through the status-returning
+ * ones (an abort is a returned false), so as to show the harness' own abort-path overhead.
+ * The single-counter increment is also measured with 'std::atomic::fetch_add', as its lower bound.
+**/
+
+// External headers
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+// Internal headers
+#include "common.hpp"
+#include "transactional.hpp"
+
+// -------------------------------------------------------------------------- //
+
+// Shared memory region parameters
+constexpr static size_t word_align = sizeof(uint64_t);
+constexpr static size_t nbwords    = 1024;
+// Benchmark parameters
+constexpr static size_t nbwarmups  = 1000;  // Discarded samples per thread and primitive
+constexpr static size_t nbsamples  = 10000; // Measured samples per thread and primitive
+constexpr static size_t read_words  = 64;   // Words read by the "N-word read" primitive
+constexpr static size_t write_words = 64;   // Words written by the "K-word commit" primitive
+constexpr static size_t alloc_words = 16;   // Words allocated by the "alloc/free" primitive
+
+/** Benchmarked primitive.
+**/
+struct Primitive final {
+    char const* name; // Printed name
+    Transaction::Mode mode; // Transaction mode
+    void (*body)(Transaction&, uint64_t*); // Transaction body, given the first word of the region
+    bool (*try_body)(Transaction&, uint64_t*); // Same body, with the status-returning operations
+};
+
+/** Benchmarked primitives, each sample is one committed transaction (retries included).
+**/
+static Primitive const primitives[] = {
+    {"empty RO TX", Transaction::Mode::read_only, [](Transaction&, uint64_t*) {}, [](Transaction&, uint64_t*) {
+        return true;
+    }},
+    {"empty RW TX", Transaction::Mode::read_write, [](Transaction&, uint64_t*) {}, [](Transaction&, uint64_t*) {
+        return true;
+    }},
+    {"1-word read", Transaction::Mode::read_only, [](Transaction& tx, uint64_t* words) {
+        uint64_t value;
+        tx.read(words, word_align, &value);
+    }, [](Transaction& tx, uint64_t* words) {
+        uint64_t value;
+        return tx.try_read(words, word_align, &value);
+    }},
+    {"1-word write", Transaction::Mode::read_write, [](Transaction& tx, uint64_t* words) {
+        uint64_t value = 1;
+        tx.write(&value, word_align, words);
+    }, [](Transaction& tx, uint64_t* words) {
+        uint64_t value = 1;
+        return tx.try_write(&value, word_align, words);
+    }},
+    {"1-word add", Transaction::Mode::read_write, [](Transaction& tx, uint64_t* words) {
+        tx.add(1, words); // Every thread increments the same counter
+    }, [](Transaction& tx, uint64_t* words) {
+        return tx.try_add(1, words);
+    }},
+    {"N-word read", Transaction::Mode::read_only, [](Transaction& tx, uint64_t* words) {
+        uint64_t values[read_words];
+        tx.read(words, sizeof(values), values);
+    }, [](Transaction& tx, uint64_t* words) {
+        uint64_t values[read_words];
+        return tx.try_read(words, sizeof(values), values);
+    }},
+    {"read-after-write", Transaction::Mode::read_write, [](Transaction& tx, uint64_t* words) {
+        uint64_t value = 2;
+        tx.write(&value, word_align, words);
+        tx.read(words, word_align, &value);
+    }, [](Transaction& tx, uint64_t* words) {
+        uint64_t value = 2;
+        return tx.try_write(&value, word_align, words) && tx.try_read(words, word_align, &value);
+    }},
+    {"K-word commit", Transaction::Mode::read_write, [](Transaction& tx, uint64_t* words) {
+        for (size_t i = 0; i < write_words; ++i) { // One write per word, to grow the write set
+            uint64_t value = i;
+            tx.write(&value, word_align, words + i);
+        }
+    }, [](Transaction& tx, uint64_t* words) {
+        for (size_t i = 0; i < write_words; ++i) {
+            uint64_t value = i;
+            if (!tx.try_write(&value, word_align, words + i))
+                return false;
+        }
+        return true;
+    }},
+    {"alloc/free", Transaction::Mode::read_write, [](Transaction& tx, uint64_t*) {
+        tx.free(tx.alloc(alloc_words * word_align));
+    }, [](Transaction& tx, uint64_t*) {
+        void* target;
+        switch (tx.try_alloc(alloc_words * word_align, &target)) {
+        case STM::Alloc::success:
+            return tx.try_free(target);
+        case STM::Alloc::nomem:
+            throw Exception::TransactionAlloc{};
+        default: // STM::Alloc::abort
+            return false;
+        }
+    }},
+};
+
+/** Latency percentiles, with the abort rate of the measured transactions.
+**/
+struct Percentiles final {
+    Chrono::Tick p50;
+    Chrono::Tick p99;
+    Chrono::Tick p999;
+    double abort_rate; // Aborted attempts over all attempts (in %)
+};
+
+/** Compute the latency percentiles of the given samples.
+ * @param samples Samples (in ns), reordered
+ * @return Percentiles of the samples
+**/
+static Percentiles percentiles(::std::vector<Chrono::Tick>& samples) {
+    ::std::sort(samples.begin(), samples.end());
+    auto at = [&](double ratio) {
+        return samples[::std::min(samples.size() - 1, static_cast<size_t>(ratio * static_cast<double>(samples.size())))];
+    };
+    return Percentiles{at(0.5), at(0.99), at(0.999), 0.};
+}
+
+/** Measure the latency of one primitive, every thread running it on the same words of a fresh region.
+ * The region is not shared with the other measurements, so that none depends on what the earlier ones left (e.g. allocations).
+ * @param tl        Transactional library to use
+ * @param primitive Primitive to measure
+ * @param nbthreads Number of concurrent threads
+ * @param status    Whether to run the status-returning body with 'transactional_try', the exception-based one otherwise
+ * @return Latency percentiles over every thread's samples
+**/
+static Percentiles measure(TransactionalLibrary const& tl, Primitive const& primitive, unsigned int nbthreads, bool status) {
+    TransactionalMemory tm{tl, word_align, nbwords * word_align};
+    ::std::vector<::std::vector<Chrono::Tick>> samples(nbthreads);
+    ::std::vector<TransactionCounters> counters(nbthreads);
+    ::std::vector<::std::thread> threads;
+    Barrier barrier{static_cast<Barrier::Counter>(nbthreads)};
+    auto words = reinterpret_cast<uint64_t*>(tm.get_start());
+    for (unsigned int i = 0; i < nbthreads; ++i) {
+        threads.emplace_back([&](unsigned int i) {
+            TransactionalThread scope{tm};
+            auto& local = samples[i];
+            local.reserve(nbsamples);
+            barrier.sync();
+            for (size_t count = 0; count < nbwarmups + nbsamples; ++count) {
+                if (count == nbwarmups)
+                    transaction_counters = TransactionCounters{};
+                Chrono chrono;
+                chrono.start();
+                if (status) {
+                    transactional_try(tm, primitive.mode, default_retry_policy, [&](Transaction& tx) {
+                        return primitive.try_body(tx, words);
+                    });
+                } else {
+                    transactional(tm, primitive.mode, [&](Transaction& tx) {
+                        primitive.body(tx, words);
+                    });
+                }
+                auto tick = chrono.delta();
+                if (count >= nbwarmups)
+                    local.push_back(tick);
+            }
+            counters[i] = transaction_counters;
+        }, i);
+    }
+    for (auto&& thread: threads)
+        thread.join();
+    ::std::vector<Chrono::Tick> merged;
+    for (auto&& local: samples)
+        merged.insert(merged.end(), local.begin(), local.end());
+    auto res = percentiles(merged);
+    size_t attempts = 0, retries = 0;
+    for (auto&& local: counters) {
+        attempts += local.attempts;
+        retries  += local.retries;
+    }
+    res.abort_rate = attempts > 0 ? 100. * static_cast<double>(retries) / static_cast<double>(attempts) : 0.;
+    return res;
+}
+
+/** Measure the latency of 'std::atomic::fetch_add' on one counter, every thread incrementing it.
+ * @param nbthreads Number of concurrent threads
+ * @return Latency percentiles over every thread's samples
+**/
+static Percentiles measure_atomic(unsigned int nbthreads) {
+    ::std::vector<::std::vector<Chrono::Tick>> samples(nbthreads);
+    ::std::vector<::std::thread> threads;
+    Barrier barrier{static_cast<Barrier::Counter>(nbthreads)};
+    ::std::atomic<uint64_t> counter{0};
+    for (unsigned int i = 0; i < nbthreads; ++i) {
+        threads.emplace_back([&](unsigned int i) {
+            auto& local = samples[i];
+            local.reserve(nbsamples);
+            barrier.sync();
+            for (size_t count = 0; count < nbwarmups + nbsamples; ++count) {
+                Chrono chrono;
+                chrono.start();
+                counter.fetch_add(1);
+                auto tick = chrono.delta();
+                if (count >= nbwarmups)
+                    local.push_back(tick);
+            }
+        }, i);
+    }
+    for (auto&& thread: threads)
+        thread.join();
+    ::std::vector<Chrono::Tick> merged;
+    for (auto&& local: samples)
+        merged.insert(merged.end(), local.begin(), local.end());
+    return percentiles(merged);
+}
+
+// -------------------------------------------------------------------------- //
+
+/** Program entry point.
+ * @param argc Arguments count
+ * @param argv Arguments values
+ * @return Program return code
+**/
+int main(int argc, char** argv) {
+    try {
+        // Parse command line option(s)
+        if (argc < 2) {
+            ::std::cout << "Usage: " << (argc > 0 ? argv[0] : "microbench") << " <library path>..." << ::std::endl;
+            return 1;
+        }
+        // The contended runs use at least 2 threads, even on a single core
+        auto const nbcontended = ::std::max(2u, ::std::thread::hardware_concurrency());
+        ::std::cout << "⎧ #samples per thread: " << nbsamples << ::std::endl;
+        ::std::cout << "⎪ #contended threads:  " << nbcontended << ::std::endl;
+        ::std::cout << "⎪ N-word read size:    " << read_words << ::std::endl;
+        ::std::cout << "⎩ K-word commit size:  " << write_words << ::std::endl;
+        for (auto nbthreads: {1u, nbcontended}) {
+            auto res = measure_atomic(nbthreads);
+            ::std::cout << "⎧ Benchmarking std::atomic (" << (nbthreads == 1 ? "uncontended" : "contended") << ", " << nbthreads << " thread(s))..." << ::std::endl;
+            ::std::cout << "⎩ " << ::std::left << ::std::setw(17) << "1-word add" << ::std::setw(7) << "atomic" << ::std::right
+                << " p50 " << ::std::setw(8) << res.p50 << " ns, p99 " << ::std::setw(8) << res.p99 << " ns, p999 " << ::std::setw(9) << res.p999 << " ns" << ::std::endl;
+        }
+        for (auto i = 1; i < argc; ++i) {
+            TransactionalLibrary tl{argv[i]};
+            for (auto nbthreads: {1u, nbcontended}) {
+                ::std::cout << "⎧ Benchmarking '" << argv[i] << "' (" << (nbthreads == 1 ? "uncontended" : "contended") << ", " << nbthreads << " thread(s))..." << ::std::endl;
+                auto count = sizeof(primitives) / sizeof(*primitives);
+                for (size_t j = 0; j < count; ++j) {
+                    for (auto status: {false, true}) {
+                        auto res = measure(tl, primitives[j], nbthreads, status);
+                        ::std::cout << (j + 1 < count || !status ? "⎪ " : "⎩ ") << ::std::left << ::std::setw(17) << (status ? "" : primitives[j].name) << ::std::setw(7) << (status ? "status" : "throw") << ::std::right
+                            << " p50 " << ::std::setw(8) << res.p50 << " ns, p99 " << ::std::setw(8) << res.p99 << " ns, p999 " << ::std::setw(9) << res.p999 << " ns, aborts " << ::std::setprecision(3) << res.abort_rate << " %" << ::std::endl;
+                    }
+                }
+            }
+        }
+        return 0;
+    } catch (::std::exception const& err) {
+        ::std::cerr << "⎧ *** EXCEPTION ***" << ::std::endl;
+        ::std::cerr << "⎩ " << err.what() << ::std::endl;
+        return 1;
+    }
+}
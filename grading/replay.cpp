@@ -0,0 +1,221 @@
+/**
+ * @file   replay.cpp
+ *
+ * @section DESCRIPTION
+ *
+ * Replay of a recorded trace (see 'grading --record') on the implementations.
+ *
+ * Each recorded stream is replayed by one thread, with no workload logic: the transactions that
+ * committed when recorded are run again, on the same offsets and sizes, until they commit, while
+ * the recorded aborted attempts are skipped. A transaction accessing a segment allocated by
+ * another stream waits for that allocation to commit. Frees are not replayed, since the replay
+ * threads do not follow the recorded commit order and could otherwise access a freed segment.
+**/
+
+// External headers
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Internal headers
+#include "common.hpp"
+#include "trace.hpp"
+#include "transactional.hpp"
+
+// -------------------------------------------------------------------------- //
+
+/** Outcome of the replay of one stream.
+**/
+struct Outcome final {
+    size_t committed; // Committed transactions
+    size_t retried;   // Retried transactions
+};
+
+/** Replay one stream.
+ * @param tm       Transactional memory to replay on
+ * @param stream   Stream to replay
+ * @param segments Start addresses of the segments, by ID, 'nullptr' while not allocated
+ * @param error    Error to set, on failure
+ * @return Replay outcome
+**/
+static Outcome replay(TransactionalMemory const& tm, Trace::Stream const& stream, ::std::atomic<void*>* segments, ::std::atomic<char const*>& error) {
+    using Op = TraceRecord::Op;
+    Outcome res{0, 0};
+    size_t maxsize = 0;
+    for (auto&& record: stream) {
+        if (record.op != Op::alloc)
+            maxsize = ::std::max<size_t>(maxsize, record.size);
+    }
+    auto const nbwords = (maxsize + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+    auto buffer = ::std::make_unique<uint64_t[]>(nbwords);
+    auto zeros  = ::std::make_unique<uint64_t[]>(nbwords);
+    ::std::vector<::std::pair<uint32_t, void*>> allocated; // Segments allocated by the running transaction
+    auto const end = stream.size();
+    size_t first = 0;
+    while (first < end && !error.load(::std::memory_order_relaxed)) {
+        // Delimit the next recorded attempt, skip it unless it committed
+        auto last = first + 1;
+        bool committed = false;
+        if (stream[first].success && (stream[first].op == Op::begin_ro || stream[first].op == Op::begin_rw)) {
+            for (; last < end; ++last) {
+                auto const& record = stream[last];
+                if (record.op == Op::end || !record.success) {
+                    committed = record.op == Op::end && record.success;
+                    ++last;
+                    break;
+                }
+            }
+        }
+        if (!committed) {
+            first = last;
+            continue;
+        }
+        // Wait for the segments allocated by the other streams
+        uint32_t ownfirst = TraceRecord::unknown; // First segment ID allocated by the transaction, IDs being allocated in order
+        for (auto i = first + 1; i + 1 < last; ++i) {
+            auto segment = stream[i].segment;
+            if (stream[i].op == Op::alloc)
+                ownfirst = ::std::min(ownfirst, segment);
+            if (stream[i].op == Op::alloc || segment == TraceRecord::unknown || segment >= ownfirst)
+                continue;
+            while (!segments[segment].load(::std::memory_order_acquire)) {
+                if (error.load(::std::memory_order_relaxed))
+                    return res;
+                ::std::this_thread::yield();
+            }
+        }
+        // Run the transaction until it commits
+        auto const ro = stream[first].op == Op::begin_ro;
+        while (true) {
+            allocated.clear();
+            auto tx = tm.begin(ro);
+            if (unlikely(tx == STM::invalid_tx)) {
+                error.store("transaction begin failed", ::std::memory_order_relaxed);
+                return res;
+            }
+            auto address = [&](TraceRecord const& record) {
+                for (auto&& [id, start]: allocated) {
+                    if (id == record.segment)
+                        return static_cast<char*>(start) + record.offset;
+                }
+                return static_cast<char*>(segments[record.segment].load(::std::memory_order_relaxed)) + record.offset;
+            };
+            bool alive = true;
+            for (auto i = first + 1; alive && i + 1 < last; ++i) {
+                auto const& record = stream[i];
+                if (record.segment == TraceRecord::unknown)
+                    continue;
+                switch (record.op) {
+                case Op::read:
+                    alive = tm.read(tx, address(record), record.size, buffer.get());
+                    break;
+                case Op::read_range:
+                    alive = tm.read_range(tx, address(record), record.size, buffer.get());
+                    break;
+                case Op::write:
+                    alive = tm.write(tx, zeros.get(), record.size, address(record));
+                    break;
+                case Op::alloc: {
+                    void* start;
+                    switch (tm.alloc(tx, record.size, &start)) {
+                    case STM::Alloc::success:
+                        allocated.emplace_back(record.segment, start);
+                        break;
+                    case STM::Alloc::abort:
+                        alive = false;
+                        break;
+                    default:
+                        error.store("memory allocation failed (insufficient memory)", ::std::memory_order_relaxed);
+                        return res;
+                    }
+                } break;
+                default: // Frees are not replayed
+                    break;
+                }
+            }
+            if (alive && tm.end(tx))
+                break;
+            ++res.retried;
+        }
+        // Publish the segments allocated
+        for (auto&& [id, start]: allocated)
+            segments[id].store(start, ::std::memory_order_release);
+        ++res.committed;
+        first = last;
+    }
+    return res;
+}
+
+// -------------------------------------------------------------------------- //
+
+/** Program entry point.
+ * @param argc Arguments count
+ * @param argv Arguments values
+ * @return Program return code
+**/
+int main(int argc, char** argv) {
+    try {
+        // Parse command line option(s)
+        if (argc < 3) {
+            ::std::cout << "Usage: " << (argc > 0 ? argv[0] : "replay") << " <trace path> <library path>..." << ::std::endl;
+            return 1;
+        }
+        Trace trace{argv[1]};
+        auto const& streams = trace.get_streams();
+        size_t nbrecords = 0;
+        for (auto&& stream: streams)
+            nbrecords += stream.size();
+        ::std::cout << "⎧ Trace:               " << argv[1] << ::std::endl;
+        ::std::cout << "⎪ #streams:            " << streams.size() << ::std::endl;
+        ::std::cout << "⎪ #operations:         " << nbrecords << ::std::endl;
+        ::std::cout << "⎪ #segments:           " << trace.get_nbsegments() << ::std::endl;
+        ::std::cout << "⎩ Region:              " << trace.get_size() << " bytes, " << trace.get_align() << "-byte aligned" << ::std::endl;
+        for (auto i = 2; i < argc; ++i) {
+            ::std::cout << "⎧ Replaying '" << argv[i] << "' with " << streams.size() << " thread(s)..." << ::std::endl;
+            TransactionalLibrary tl{argv[i]};
+            TransactionalMemory tm{tl, trace.get_align(), trace.get_size()};
+            auto segments = ::std::make_unique<::std::atomic<void*>[]>(trace.get_nbsegments());
+            for (size_t j = 0; j < trace.get_nbsegments(); ++j)
+                segments[j].store(j == 0 ? tm.get_start() : nullptr, ::std::memory_order_relaxed);
+            ::std::atomic<char const*> error{nullptr};
+            ::std::vector<Outcome> outcomes(streams.size());
+            ::std::vector<::std::thread> threads;
+            Barrier barrier{static_cast<Barrier::Counter>(streams.size() + 1)};
+            for (size_t j = 0; j < streams.size(); ++j) {
+                threads.emplace_back([&](size_t j) {
+                    TransactionalThread scope{tm};
+                    barrier.sync();
+                    outcomes[j] = replay(tm, streams[j], segments.get(), error);
+                }, j);
+            }
+            Chrono chrono;
+            chrono.start(); // Before the barrier, as the threads may be done before it returns here
+            barrier.sync();
+            for (auto&& thread: threads)
+                thread.join();
+            chrono.stop();
+            if (unlikely(error.load(::std::memory_order_relaxed))) {
+                ::std::cout << "⎩ " << error.load(::std::memory_order_relaxed) << ::std::endl;
+                return 1;
+            }
+            Outcome total{0, 0};
+            for (auto&& outcome: outcomes) {
+                total.committed += outcome.committed;
+                total.retried   += outcome.retried;
+            }
+            auto const time = static_cast<double>(chrono.get_tick());
+            auto const attempts = static_cast<double>(total.committed + total.retried);
+            ::std::cout << "⎪ Total user execution time: " << (time / 1000000.) << " ms" << ::std::endl;
+            ::std::cout << "⎪ #committed TX: " << total.committed << ", abort rate: " << (attempts > 0. ? 100. * static_cast<double>(total.retried) / attempts : 0.) << " %" << ::std::endl;
+            ::std::cout << "⎩ Throughput: " << (static_cast<double>(total.committed) * 1000000000. / time) << " TX/s" << ::std::endl;
+        }
+        return 0;
+    } catch (::std::exception const& err) {
+        ::std::cerr << "⎧ *** EXCEPTION ***" << ::std::endl;
+        ::std::cerr << "⎩ " << err.what() << ::std::endl;
+        return 1;
+    }
+}
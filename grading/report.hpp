@@ -0,0 +1,375 @@
+/**
+ * @file   report.hpp
+ *
+ * @section DESCRIPTION
+ *
+ * Machine-readable reports: JSON writing and reading helpers, and description of the run environment.
+**/
+
+#pragma once
+
+// External headers
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sys/utsname.h>
+
+// Internal headers
+#include "common.hpp"
+
+#ifndef GRADING_CXXFLAGS
+    #define GRADING_CXXFLAGS "<unknown>"
+#endif
+
+// -------------------------------------------------------------------------- //
+namespace Exception {
+
+/** Exception tree.
+**/
+EXCEPTION(Report, Any, "report exception");
+    EXCEPTION(ReportRead, Report, "unable to read the report file");
+    EXCEPTION(ReportParse, Report, "the report file is not valid JSON");
+    EXCEPTION(ReportMismatch, Report, "the baseline report was made with other run parameters");
+
+}
+// -------------------------------------------------------------------------- //
+
+/** Quote a string for JSON.
+ * @param text String to quote
+ * @return Quoted and escaped string
+**/
+static ::std::string json_quote(::std::string const& text) {
+    ::std::string res{"\""};
+    for (auto c: text) {
+        switch (c) {
+        case '"':  res += "\\\""; break;
+        case '\\': res += "\\\\"; break;
+        case '\n': res += "\\n"; break;
+        case '\r': res += "\\r"; break;
+        case '\t': res += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20) {
+                char buf[8];
+                ::std::snprintf(buf, sizeof(buf), "\\u%04x", static_cast<unsigned int>(c));
+                res += buf;
+            } else {
+                res += c;
+            }
+        }
+    }
+    return res + "\"";
+}
+
+/** Parsed JSON value.
+**/
+class Json final {
+public:
+    /** Value type enum class.
+    **/
+    enum class Type {
+        null,
+        boolean,
+        number,
+        string,
+        array,
+        object
+    };
+private:
+    Type type = Type::null;
+    bool boolean = false;
+    double number = 0.;
+    ::std::string string;
+    ::std::vector<Json> array;
+    ::std::vector<::std::pair<::std::string, Json>> object;
+private:
+    /** Recursive descent parser over a text.
+    **/
+    class Parser final {
+    private:
+        ::std::string const& text; // Parsed text
+        size_t pos;                // Current position
+    public:
+        /** Text constructor.
+         * @param text Text to parse
+        **/
+        Parser(::std::string const& text): text{text}, pos{0} {}
+    private:
+        /** Skip white spaces, then peek at the next character.
+         * @return Next character, '\0' at the end
+        **/
+        char peek() {
+            while (pos < text.size() && (text[pos] == ' ' || text[pos] == '\t' || text[pos] == '\n' || text[pos] == '\r'))
+                ++pos;
+            return pos < text.size() ? text[pos] : '\0';
+        }
+        /** Consume the expected word.
+         * @param word Expected word
+        **/
+        void expect(char const* word) {
+            peek();
+            for (; *word; ++word, ++pos) {
+                if (unlikely(pos >= text.size() || text[pos] != *word))
+                    throw Exception::ReportParse{};
+            }
+        }
+        /** Parse a string, at its opening quote.
+         * @return Parsed string
+        **/
+        ::std::string parse_string() {
+            expect("\"");
+            ::std::string res;
+            while (true) {
+                if (unlikely(pos >= text.size()))
+                    throw Exception::ReportParse{};
+                auto c = text[pos++];
+                if (c == '"')
+                    return res;
+                if (c != '\\') {
+                    res += c;
+                    continue;
+                }
+                if (unlikely(pos >= text.size()))
+                    throw Exception::ReportParse{};
+                switch (c = text[pos++]) {
+                case 'b': res += '\b'; break;
+                case 'f': res += '\f'; break;
+                case 'n': res += '\n'; break;
+                case 'r': res += '\r'; break;
+                case 't': res += '\t'; break;
+                case 'u': { // Basic multilingual plane only, as UTF-8
+                    if (unlikely(pos + 4 > text.size()))
+                        throw Exception::ReportParse{};
+                    auto code = ::std::strtoul(text.substr(pos, 4).c_str(), nullptr, 16);
+                    pos += 4;
+                    if (code < 0x80) {
+                        res += static_cast<char>(code);
+                    } else if (code < 0x800) {
+                        res += static_cast<char>(0xc0 | (code >> 6));
+                        res += static_cast<char>(0x80 | (code & 0x3f));
+                    } else {
+                        res += static_cast<char>(0xe0 | (code >> 12));
+                        res += static_cast<char>(0x80 | ((code >> 6) & 0x3f));
+                        res += static_cast<char>(0x80 | (code & 0x3f));
+                    }
+                } break;
+                default: // '"', '\\' and '/'
+                    res += c;
+                }
+            }
+        }
+    public:
+        /** Parse one value.
+         * @return Parsed value
+        **/
+        Json parse_value() {
+            Json res;
+            switch (peek()) {
+            case '{':
+                res.type = Type::object;
+                expect("{");
+                if (peek() == '}') {
+                    expect("}");
+                    break;
+                }
+                while (true) {
+                    auto key = parse_string();
+                    expect(":");
+                    res.object.emplace_back(::std::move(key), parse_value());
+                    if (peek() != ',')
+                        break;
+                    expect(",");
+                }
+                expect("}");
+                break;
+            case '[':
+                res.type = Type::array;
+                expect("[");
+                if (peek() == ']') {
+                    expect("]");
+                    break;
+                }
+                while (true) {
+                    res.array.push_back(parse_value());
+                    if (peek() != ',')
+                        break;
+                    expect(",");
+                }
+                expect("]");
+                break;
+            case '"':
+                res.type = Type::string;
+                res.string = parse_string();
+                break;
+            case 't':
+                expect("true");
+                res.type = Type::boolean;
+                res.boolean = true;
+                break;
+            case 'f':
+                expect("false");
+                res.type = Type::boolean;
+                break;
+            case 'n':
+                expect("null");
+                break;
+            default: {
+                char* end;
+                res.type = Type::number;
+                res.number = ::std::strtod(text.c_str() + pos, &end);
+                if (unlikely(end == text.c_str() + pos))
+                    throw Exception::ReportParse{};
+                pos = end - text.c_str();
+            }
+            }
+            return res;
+        }
+        /** Check that only white spaces remain.
+        **/
+        void finish() {
+            if (unlikely(peek() != '\0'))
+                throw Exception::ReportParse{};
+        }
+    };
+public:
+    /** Parse a JSON file.
+     * @param path Path of the file to parse
+     * @return Parsed value
+    **/
+    static Json load(::std::string const& path) {
+        ::std::ifstream file{path};
+        if (unlikely(!file))
+            throw Exception::ReportRead{};
+        return parse(::std::string{::std::istreambuf_iterator<char>{file}, ::std::istreambuf_iterator<char>{}});
+    }
+    /** Parse a JSON text.
+     * @param text Text to parse
+     * @return Parsed value
+    **/
+    static Json parse(::std::string const& text) {
+        Parser parser{text};
+        auto res = parser.parse_value();
+        parser.finish();
+        return res;
+    }
+public:
+    /** Get the value type.
+     * @return Value type
+    **/
+    auto get_type() const noexcept {
+        return type;
+    }
+    /** Get the number, if the value is one.
+     * @param def Value to return if the value is not a number
+     * @return Number, or the default
+    **/
+    double as_number(double def = 0.) const noexcept {
+        return type == Type::number ? number : def;
+    }
+    /** Get the string, if the value is one.
+     * @return String, empty if the value is not a string
+    **/
+    ::std::string const& as_string() const noexcept {
+        return string;
+    }
+    /** Get the elements, if the value is an array.
+     * @return Elements, none if the value is not an array
+    **/
+    auto const& as_array() const noexcept {
+        return array;
+    }
+    /** Get the members, if the value is an object.
+     * @return Members, none if the value is not an object
+    **/
+    auto const& as_object() const noexcept {
+        return object;
+    }
+    /** Find a member, if the value is an object.
+     * @param key Member key
+     * @return Member value, 'nullptr' if there is no such member
+    **/
+    Json const* find(char const* key) const noexcept {
+        for (auto&& member: object) {
+            if (member.first == key)
+                return &member.second;
+        }
+        return nullptr;
+    }
+    /** Compare with another value, members being matched by key.
+     * @param other Value to compare with
+     * @return Whether both values are equal
+    **/
+    bool operator==(Json const& other) const noexcept {
+        if (type != other.type)
+            return false;
+        switch (type) {
+        case Type::null:
+            return true;
+        case Type::boolean:
+            return boolean == other.boolean;
+        case Type::number:
+            return number == other.number;
+        case Type::string:
+            return string == other.string;
+        case Type::array:
+            return array == other.array;
+        case Type::object:
+            if (object.size() != other.object.size())
+                return false;
+            for (auto&& member: object) {
+                auto const* match = other.find(member.first.c_str());
+                if (!match || !(member.second == *match))
+                    return false;
+            }
+            return true;
+        }
+        return false;
+    }
+    /** Compare with another value, members being matched by key.
+     * @param other Value to compare with
+     * @return Whether both values differ
+    **/
+    bool operator!=(Json const& other) const noexcept {
+        return !(*this == other);
+    }
+};
+
+/** Write the run environment, as a JSON object.
+ * @param output Output stream
+**/
+static void write_environment(::std::ostream& output) {
+    ::std::string cpu_model{"<unknown>"};
+    { // First model name of '/proc/cpuinfo'
+        ::std::ifstream cpuinfo{"/proc/cpuinfo"};
+        ::std::string line;
+        while (::std::getline(cpuinfo, line)) {
+            if (line.compare(0, 10, "model name") != 0)
+                continue;
+            auto colon = line.find(':');
+            if (colon != ::std::string::npos)
+                cpu_model = line.substr(line.find_first_not_of(' ', colon + 1));
+            break;
+        }
+    }
+    struct ::utsname name;
+    auto has_name = ::uname(&name) == 0;
+    char date[32];
+    auto now = ::std::time(nullptr);
+    struct ::tm utc;
+    ::std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", ::gmtime_r(&now, &utc));
+    output << "{\"date\": " << json_quote(date)
+        << ", \"hostname\": " << json_quote(has_name ? name.nodename : "<unknown>")
+        << ", \"kernel\": " << json_quote(has_name ? ::std::string{name.sysname} + " " + name.release + " " + name.version : "<unknown>")
+        << ", \"machine\": " << json_quote(has_name ? name.machine : "<unknown>")
+        << ", \"cpu_model\": " << json_quote(cpu_model)
+        << ", \"hardware_concurrency\": " << ::std::thread::hardware_concurrency()
+        << ", \"compiler\": " << json_quote(__VERSION__)
+        << ", \"compiler_flags\": " << json_quote(GRADING_CXXFLAGS) << "}";
+}
@@ -0,0 +1,170 @@
+/**
+ * @file   topology.hpp
+ *
+ * @section DESCRIPTION
+ *
+ * CPU topology discovery (from sysfs) and placement of the worker threads on the CPUs.
+**/
+
+#pragma once
+
+// External headers
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <pthread.h>
+#include <sched.h>
+
+// Internal headers
+#include "common.hpp"
+
+// -------------------------------------------------------------------------- //
+
+/** CPU topology of the CPUs the process may run on.
+**/
+class Topology final {
+public:
+    /** One usable CPU.
+    **/
+    struct Cpu final {
+        unsigned int id;      // CPU (i.e. hardware thread) ID
+        unsigned int package; // Physical package ID
+        unsigned int core;    // Core ID, in its package
+        unsigned int rank;    // Rank among the usable SMT siblings of its core
+    };
+private:
+    ::std::vector<Cpu> cpus; // Usable CPUs, by growing ID
+    size_t nbcores;          // Number of cores with at least one usable CPU
+    size_t nbpackages;       // Number of packages with at least one usable CPU
+private:
+    /** Read one topology attribute of a CPU from sysfs.
+     * @param cpu  CPU ID
+     * @param name Attribute name
+     * @param def  Value if the attribute cannot be read
+     * @return Attribute value
+    **/
+    static unsigned int read_attribute(unsigned int cpu, char const* name, unsigned int def) {
+        ::std::ifstream file{"/sys/devices/system/cpu/cpu" + ::std::to_string(cpu) + "/topology/" + name};
+        unsigned int res;
+        if (!(file >> res))
+            return def;
+        return res;
+    }
+public:
+    /** Discovery constructor, the usable CPUs being the ones of the process' affinity mask.
+    **/
+    Topology() {
+        ::cpu_set_t set;
+        CPU_ZERO(&set);
+        if (unlikely(::sched_getaffinity(0, sizeof(set), &set) != 0))
+            throw Exception::Parameter{"unable to get the CPU affinity of the process"};
+        for (unsigned int id = 0; id < CPU_SETSIZE; ++id) {
+            if (CPU_ISSET(id, &set)) // Without sysfs, every CPU is taken for a core of its own
+                cpus.push_back(Cpu{id, read_attribute(id, "physical_package_id", 0), read_attribute(id, "core_id", id), 0});
+        }
+        ::std::vector<::std::pair<unsigned int, unsigned int>> cores;
+        ::std::vector<unsigned int> packages;
+        for (auto&& cpu: cpus) {
+            auto core = ::std::make_pair(cpu.package, cpu.core);
+            cpu.rank = static_cast<unsigned int>(::std::count(cores.begin(), cores.end(), core));
+            cores.push_back(core);
+            packages.push_back(cpu.package);
+        }
+        ::std::sort(cores.begin(), cores.end());
+        ::std::sort(packages.begin(), packages.end());
+        nbcores = ::std::unique(cores.begin(), cores.end()) - cores.begin();
+        nbpackages = ::std::unique(packages.begin(), packages.end()) - packages.begin();
+    }
+public:
+    /** Get the usable CPUs.
+     * @return Usable CPUs, by growing ID
+    **/
+    auto const& get_cpus() const noexcept {
+        return cpus;
+    }
+    /** Get the number of cores with at least one usable CPU.
+     * @return Number of cores
+    **/
+    auto get_nbcores() const noexcept {
+        return nbcores;
+    }
+    /** Get the number of packages with at least one usable CPU.
+     * @return Number of packages
+    **/
+    auto get_nbpackages() const noexcept {
+        return nbpackages;
+    }
+    /** Place worker threads on the usable CPUs, cycling through the CPUs if there are more threads.
+     * @param placement 'none', 'compact' (SMT siblings first), 'scatter' (one CPU per core first) or a CPU list (e.g. '0,2,4-7')
+     * @param nbthreads Number of threads to place
+     * @return CPU of each thread, empty for 'none'
+    **/
+    ::std::vector<unsigned int> place(::std::string const& placement, size_t nbthreads) const {
+        ::std::vector<unsigned int> order;
+        if (placement == "none") {
+            return order;
+        } else if (placement == "compact" || placement == "scatter") {
+            auto sorted = cpus;
+            if (placement == "compact") {
+                ::std::sort(sorted.begin(), sorted.end(), [](Cpu const& a, Cpu const& b) {
+                    return ::std::tie(a.package, a.core, a.rank) < ::std::tie(b.package, b.core, b.rank);
+                });
+            } else { // Alternate packages too, so that they share the load
+                ::std::sort(sorted.begin(), sorted.end(), [](Cpu const& a, Cpu const& b) {
+                    return ::std::tie(a.rank, a.core, a.package) < ::std::tie(b.rank, b.core, b.package);
+                });
+            }
+            for (auto&& cpu: sorted)
+                order.push_back(cpu.id);
+        } else {
+            order = parse_list(placement);
+            for (auto id: order) {
+                if (unlikely(::std::none_of(cpus.begin(), cpus.end(), [&](Cpu const& cpu) { return cpu.id == id; })))
+                    throw Exception::Parameter{"the placement CPU list holds a CPU the process cannot run on"};
+            }
+        }
+        if (unlikely(order.empty()))
+            throw Exception::Parameter{"no CPU to place the worker threads on"};
+        ::std::vector<unsigned int> res(nbthreads);
+        for (size_t i = 0; i < nbthreads; ++i)
+            res[i] = order[i % order.size()];
+        return res;
+    }
+public:
+    /** Parse a CPU list, in the sysfs format (e.g. '0,2,4-7').
+     * @param list CPU list
+     * @return CPU IDs, in list order
+    **/
+    static ::std::vector<unsigned int> parse_list(::std::string const& list) {
+        ::std::vector<unsigned int> res;
+        ::std::istringstream stream{list};
+        ::std::string item;
+        while (::std::getline(stream, item, ',')) {
+            unsigned int first, last;
+            char dash;
+            ::std::istringstream range{item};
+            if (!(range >> first))
+                throw Exception::Parameter{"the placement must be 'none', 'compact', 'scatter' or a CPU list like '0,2,4-7'"};
+            last = first;
+            if ((range >> dash) && (dash != '-' || !(range >> last) || last < first))
+                throw Exception::Parameter{"the placement must be 'none', 'compact', 'scatter' or a CPU list like '0,2,4-7'"};
+            for (auto id = first; id <= last; ++id)
+                res.push_back(id);
+        }
+        return res;
+    }
+    /** Pin the calling thread to one CPU.
+     * @param cpu CPU ID
+     * @return Whether the operation is a success
+    **/
+    static bool pin(unsigned int cpu) noexcept {
+        ::cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        return ::pthread_setaffinity_np(::pthread_self(), sizeof(set), &set) == 0;
+    }
+};
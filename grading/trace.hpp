@@ -0,0 +1,269 @@
+/**
+ * @file   trace.hpp
+ *
+ * @section DESCRIPTION
+ *
+ * Recording of the transactional operations of a run, and loading of the recorded traces.
+ *
+ * A trace holds one stream of operations per thread. Addresses are stored as (segment, offset)
+ * pairs, segment 0 being the first segment of the region and the others numbered by allocation,
+ * so that a trace can be replayed on any library, wherever it maps its segments.
+**/
+
+#pragma once
+
+// External headers
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <vector>
+
+// Internal headers
+#include "common.hpp"
+#include "transactional.hpp"
+
+// -------------------------------------------------------------------------- //
+namespace Exception {
+
+/** Exception tree.
+**/
+EXCEPTION(Trace, Any, "trace exception");
+    EXCEPTION(TraceWrite, Trace, "unable to write the trace file");
+    EXCEPTION(TraceRead, Trace, "unable to read the trace file, or not a trace file");
+
+}
+// -------------------------------------------------------------------------- //
+
+/** One recorded operation.
+**/
+struct TraceRecord final {
+    using Op = TransactionalTracer::Op;
+    constexpr static uint32_t unknown = static_cast<uint32_t>(-1); // Segment of an address in no known segment
+    Op       op;       // Operation
+    uint8_t  success;  // Whether the operation succeeded
+    uint16_t reserved; // Padding, set to 0
+    uint32_t segment;  // Segment accessed, allocated or freed (0 for begin and end)
+    uint32_t offset;   // Offset in the segment (in bytes)
+    uint32_t size;     // Size accessed or allocated (in bytes)
+};
+static_assert(sizeof(TraceRecord) == 16, "Expected 16-byte trace records");
+
+/** Trace file header, followed by the streams, each being its record count (as 'uint64_t') then its records.
+**/
+struct TraceHeader final {
+    constexpr static char magic_value[8] = {'T', 'M', 'T', 'R', 'A', 'C', 'E', '1'};
+    char     magic[8];   // Magic value
+    uint64_t align;      // Shared memory region alignment (in bytes)
+    uint64_t size;       // Shared memory region first segment's size (in bytes)
+    uint64_t nbsegments; // Number of segment IDs used, the first segment included
+    uint64_t nbstreams;  // Number of streams
+};
+
+/** Loaded trace.
+**/
+class Trace final {
+public:
+    using Stream = ::std::vector<TraceRecord>;
+private:
+    TraceHeader header;           // File header
+    ::std::vector<Stream> streams; // Per-thread streams
+public:
+    /** Load constructor.
+     * @param path Path of the trace file
+    **/
+    Trace(char const* path) {
+        ::std::ifstream file{path, ::std::ios::binary};
+        if (unlikely(!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || ::std::memcmp(header.magic, TraceHeader::magic_value, sizeof(header.magic)) != 0))
+            throw Exception::TraceRead{};
+        streams.resize(header.nbstreams);
+        for (auto&& stream: streams) {
+            uint64_t count;
+            if (unlikely(!file.read(reinterpret_cast<char*>(&count), sizeof(count))))
+                throw Exception::TraceRead{};
+            stream.resize(count);
+            if (unlikely(!file.read(reinterpret_cast<char*>(stream.data()), count * sizeof(TraceRecord))))
+                throw Exception::TraceRead{};
+        }
+    }
+public:
+    /** Get the recorded region alignment.
+     * @return Alignment (in bytes)
+    **/
+    auto get_align() const noexcept {
+        return header.align;
+    }
+    /** Get the recorded first segment's size.
+     * @return Size (in bytes)
+    **/
+    auto get_size() const noexcept {
+        return header.size;
+    }
+    /** Get the number of segment IDs used.
+     * @return Number of segment IDs
+    **/
+    auto get_nbsegments() const noexcept {
+        return header.nbsegments;
+    }
+    /** Get the recorded streams.
+     * @return Streams, one per recording thread
+    **/
+    auto const& get_streams() const noexcept {
+        return streams;
+    }
+};
+
+/** Recorder of the operations of every thread, into one stream per thread.
+**/
+class TraceRecorder final: public TransactionalTracer, private NonCopyable {
+private:
+    /** Known segment.
+    **/
+    struct Segment final {
+        uint32_t id;   // Segment ID
+        size_t   size; // Segment size (in bytes)
+    };
+    /** Per-thread stream, with the transaction running.
+    **/
+    struct Stream final {
+        Trace::Stream records;                  // Recorded operations
+        ::std::vector<uintptr_t> allocated;     // Segments allocated by the running transaction
+        ::std::vector<uintptr_t> freed;         // Segments freed by the running transaction
+    };
+    /** Thread's stream binding.
+    **/
+    struct Binding final {
+        uint64_t generation; // Recorder generation the stream belongs to
+        Stream*  stream;     // Bound stream
+    };
+private:
+    inline static ::std::atomic<uint64_t> generations{0}; // Generation counter, to tell apart recorders at the same address
+    inline static thread_local Binding binding{0, nullptr}; // Calling thread's binding
+private:
+    TransactionalMemory& tm; // Recorded transactional memory
+    uint64_t generation;     // This recorder's generation
+    ::std::mutex streams_lock; // Stream list lock
+    ::std::vector<::std::unique_ptr<Stream>> streams; // Streams, in registration order
+    ::std::shared_mutex segments_lock; // Segment map lock
+    ::std::map<uintptr_t, Segment> segments; // Committed and pending segments, by start address
+    ::std::atomic<uint32_t> nbsegments{1}; // Number of segment IDs used
+public:
+    /** Record constructor, recording starts right away and ends with the recorder.
+     * @param tm Transactional memory to record, with no transaction running
+    **/
+    TraceRecorder(TransactionalMemory& tm): tm{tm}, generation{generations.fetch_add(1, ::std::memory_order_relaxed) + 1} {
+        segments.emplace(reinterpret_cast<uintptr_t>(tm.get_start()), Segment{0, tm.get_size()});
+        tm.set_tracer(this);
+    }
+    /** Stop recording destructor, with no transaction running.
+    **/
+    ~TraceRecorder() {
+        tm.set_tracer(nullptr);
+    }
+private:
+    /** Get the calling thread's stream, registering it on first use.
+     * @return Calling thread's stream
+    **/
+    Stream& get_stream() {
+        if (likely(binding.generation == generation))
+            return *binding.stream;
+        ::std::unique_lock<decltype(streams_lock)> guard{streams_lock};
+        streams.push_back(::std::make_unique<Stream>());
+        binding = Binding{generation, streams.back().get()};
+        return *binding.stream;
+    }
+    /** Locate an address in the known segments.
+     * @param address Address to locate
+     * @param record  Record to set the segment and offset of
+    **/
+    void locate(void const* address, TraceRecord& record) {
+        auto addr = reinterpret_cast<uintptr_t>(address);
+        ::std::shared_lock<decltype(segments_lock)> guard{segments_lock};
+        auto it = segments.upper_bound(addr);
+        if (unlikely(it == segments.begin() || addr >= (--it)->first + it->second.size)) {
+            record.segment = TraceRecord::unknown;
+            return;
+        }
+        record.segment = it->second.id;
+        record.offset  = static_cast<uint32_t>(addr - it->first);
+    }
+    /** Settle the segments allocated and freed by the calling thread's transaction, once it ended.
+     * @param stream    Calling thread's stream
+     * @param committed Whether the transaction committed
+    **/
+    void settle(Stream& stream, bool committed) {
+        auto& gone = committed ? stream.freed : stream.allocated;
+        if (!gone.empty()) {
+            ::std::unique_lock<decltype(segments_lock)> guard{segments_lock};
+            for (auto addr: gone)
+                segments.erase(addr);
+        }
+        stream.allocated.clear();
+        stream.freed.clear();
+    }
+public:
+    /** [thread-safe] Record one operation.
+     * @param op      Operation
+     * @param address Shared address accessed, allocated or freed
+     * @param size    Size accessed or allocated (in bytes)
+     * @param success Whether the operation succeeded
+    **/
+    void trace(Op op, void const* address, size_t size, bool success) noexcept override {
+        try {
+            auto& stream = get_stream();
+            TraceRecord record{op, success, 0, 0, 0, static_cast<uint32_t>(size)};
+            switch (op) {
+            case Op::begin_ro:
+            case Op::begin_rw:
+                break;
+            case Op::alloc:
+                if (success) {
+                    record.segment = nbsegments.fetch_add(1, ::std::memory_order_relaxed);
+                    auto addr = reinterpret_cast<uintptr_t>(address);
+                    {
+                        ::std::unique_lock<decltype(segments_lock)> guard{segments_lock};
+                        segments.insert_or_assign(addr, Segment{record.segment, size});
+                    }
+                    stream.allocated.push_back(addr);
+                }
+                break;
+            case Op::free:
+                locate(address, record);
+                if (success)
+                    stream.freed.push_back(reinterpret_cast<uintptr_t>(address));
+                break;
+            case Op::end:
+                break;
+            default:
+                locate(address, record);
+            }
+            stream.records.push_back(record);
+            if (op == Op::end || !success) // The transaction ended, or was aborted by the failed operation
+                settle(stream, op == Op::end && success);
+        } catch (...) { // Out of memory: the trace misses that operation
+        }
+    }
+    /** Save the trace, with no transaction running.
+     * @param path Path of the trace file to write
+    **/
+    void save(char const* path) {
+        ::std::ofstream file{path, ::std::ios::binary | ::std::ios::trunc};
+        TraceHeader header;
+        ::std::memcpy(header.magic, TraceHeader::magic_value, sizeof(header.magic));
+        header.align      = tm.get_align();
+        header.size       = tm.get_size();
+        header.nbsegments = nbsegments.load(::std::memory_order_relaxed);
+        header.nbstreams  = streams.size();
+        file.write(reinterpret_cast<char const*>(&header), sizeof(header));
+        for (auto&& stream: streams) {
+            uint64_t count = stream->records.size();
+            file.write(reinterpret_cast<char const*>(&count), sizeof(count));
+            file.write(reinterpret_cast<char const*>(stream->records.data()), count * sizeof(TraceRecord));
+        }
+        if (unlikely(!file.flush()))
+            throw Exception::TraceWrite{};
+    }
+};
@@ -28,10 +28,16 @@ extern "C" {
 #include <dlfcn.h>
 #include <limits.h>
 }
+#include <cstddef>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 // Internal headers
 namespace STM {
 #include <tm.hpp>
+#include <tm_ext.h>
 }
 #include "common.hpp"
 
@@ -45,6 +51,7 @@ EXCEPTION(Path, Any, "path exception");
 EXCEPTION(Module, Any, "transaction library exception");
     EXCEPTION(ModuleLoading, Module, "unable to load a transaction library");
     EXCEPTION(ModuleSymbol, Module, "symbol not found in loaded libraries");
+    EXCEPTION(ModuleDurable, Module, "the transaction library cannot create durable regions");
 EXCEPTION(Transaction, Any, "transaction manager exception");
     EXCEPTION(TransactionAlign, Transaction, "incorrect alignment detected before transactional operation");
     EXCEPTION(TransactionReadOnly, Transaction, "tried to write/alloc/free using a read-only transaction");
@@ -52,6 +59,7 @@ EXCEPTION(Transaction, Any, "transaction manager exception");
     EXCEPTION(TransactionBegin, Transaction, "transaction begin failed");
     EXCEPTION(TransactionAlloc, Transaction, "memory allocation failed (insufficient memory)");
     EXCEPTION(TransactionRetry, Transaction, "transaction aborted and can be retried");
+    EXCEPTION(TransactionGiveUp, Transaction, "transaction given up after a write, which the library cannot discard");
     EXCEPTION(TransactionNotLastSegment, Transaction, "trying to deallocate the first segment");
 EXCEPTION(Shared, Any, "operation in shared memory exception");
     EXCEPTION(SharedAlign, Shared, "address in shared memory is not properly aligned for the specified type");
@@ -80,6 +88,23 @@ private:
     using FnWrite   = decltype(&STM::tm_write);
     using FnAlloc   = decltype(&STM::tm_alloc);
     using FnFree    = decltype(&STM::tm_free);
+    using FnExtQuery = decltype(&STM::tm_ext_query);
+    using FnReadRange = decltype(STM::tm_ext::read_range);
+    using FnReadWord = decltype(STM::tm_ext::read_word);
+    using FnWriteWord = decltype(STM::tm_ext::write_word);
+    using FnStats   = decltype(STM::tm_ext::stats);
+    using FnThread  = decltype(STM::tm_ext::thread_init);
+    using FnAbort   = decltype(STM::tm_ext::abort);
+    using FnCreateDurable = decltype(STM::tm_ext::create_durable);
+    using FnAdd     = decltype(STM::tm_ext::add);
+public:
+    /** Settings of the durable regions, see 'tm_ext::create_durable'.
+    **/
+    struct Durable final {
+        ::std::string path; // Path of the file backing the regions, empty for volatile regions
+        long latency_us;    // Longest wait for concurrent commits to share a sync (in µs)
+        size_t capacity;    // Size of the backing file (in bytes), 0 for the library's default
+    };
 private:
     void*     module;     // Module opaque handler
     FnCreate  tm_create;  // Module's initialization function
@@ -93,6 +118,16 @@ private:
     FnWrite   tm_write;   // Module's shared memory write function
     FnAlloc   tm_alloc;   // Module's shared memory allocation function
     FnFree    tm_free;    // Module's shared memory freeing function
+    FnReadRange tm_read_range; // Module's bulk read function (optional, null if not exported)
+    FnReadWord  tm_read_word;  // Module's single-word read function (optional extension)
+    FnWriteWord tm_write_word; // Module's single-word write function (optional extension)
+    FnStats   tm_stats;       // Module's statistics query function (optional extension)
+    FnThread  tm_thread_init; // Module's thread preparation function (optional extension)
+    FnThread  tm_thread_fini; // Module's thread release function (optional extension)
+    FnAbort   tm_abort;       // Module's voluntary abort function (optional extension)
+    FnCreateDurable tm_create_durable; // Module's durable region creation function (optional extension)
+    FnAdd     tm_add;         // Module's blind addition function (optional extension)
+    Durable   durable;        // Settings of the regions created from now on
 private:
     /** Solve a symbol from its name, and bind it to the given function.
      * @param name Name of the symbol to resolve
@@ -107,11 +142,19 @@ private:
     template<class Signature> void solve(char const* name, Signature& func) const {
         func = solve<Signature>(name);
     }
+    /** Solve an optional symbol from its name, and bind it to the given function (null if missing).
+     * @param name Name of the symbol to resolve
+     * @param func Target function to bind
+    **/
+    template<class Signature> void solve_optional(char const* name, Signature& func) const {
+        auto res = ::dlsym(module, name);
+        func = res ? *reinterpret_cast<Signature*>(&res) : nullptr;
+    }
 public:
     /** Loader constructor.
      * @param path  Path to the library to load
     **/
-    TransactionalLibrary(char const* path) {
+    TransactionalLibrary(char const* path): durable{"", 0, 0} {
         { // Resolve path and load module
             char resolved[PATH_MAX];
             if (unlikely(!realpath(path, resolved)))
@@ -133,12 +176,107 @@ public:
             solve("tm_alloc", tm_alloc);
             solve("tm_free", tm_free);
         }
+        { // Bind module's optional extensions, the extension table taking precedence
+            solve_optional("tm_read_range", tm_read_range);
+            tm_read_word   = nullptr;
+            tm_write_word  = nullptr;
+            tm_stats       = nullptr;
+            tm_thread_init = nullptr;
+            tm_thread_fini = nullptr;
+            tm_abort       = nullptr;
+            tm_create_durable = nullptr;
+            tm_add         = nullptr;
+            FnExtQuery tm_ext_query;
+            solve_optional("tm_ext_query", tm_ext_query);
+            auto ext = tm_ext_query ? tm_ext_query(TM_EXT_VERSION) : nullptr;
+            if (ext && ext->version == TM_EXT_VERSION && ext->size >= offsetof(STM::tm_ext, abort)) { // Entries appended later are read only if provided
+                if (ext->read_range)
+                    tm_read_range = ext->read_range;
+                tm_read_word   = ext->read_word;
+                tm_write_word  = ext->write_word;
+                tm_stats       = ext->stats;
+                tm_thread_init = ext->thread_init;
+                tm_thread_fini = ext->thread_fini;
+                if (ext->size >= offsetof(STM::tm_ext, abort) + sizeof(ext->abort))
+                    tm_abort = ext->abort;
+                if (ext->size >= offsetof(STM::tm_ext, create_durable) + sizeof(ext->create_durable))
+                    tm_create_durable = ext->create_durable;
+                if (ext->size >= offsetof(STM::tm_ext, add) + sizeof(ext->add))
+                    tm_add = ext->add;
+            }
+        }
     }
     /** Unloader destructor.
     **/
     ~TransactionalLibrary() noexcept {
         ::dlclose(module); // Close loaded module
     }
+public:
+    /** List the optional extensions the module provides.
+     * @return Comma-separated extension names, empty for none
+    **/
+    ::std::string get_extensions() const {
+        ::std::string res;
+        auto add = [&](bool provided, char const* name) {
+            if (!provided)
+                return;
+            if (!res.empty())
+                res += ", ";
+            res += name;
+        };
+        add(tm_read_range, "range reads");
+        add(tm_read_word || tm_write_word, "single-word operations");
+        add(tm_stats, "statistics");
+        add(tm_thread_init || tm_thread_fini, "thread hooks");
+        add(tm_abort, "voluntary aborts");
+        add(tm_create_durable, "durable regions");
+        add(tm_add, "blind additions");
+        return res;
+    }
+    /** Check whether the module can create durable regions.
+     * @return Whether it can
+    **/
+    bool has_durable() const noexcept {
+        return tm_create_durable;
+    }
+    /** Make the regions created from now on durable (each one reset), or volatile again, throw if the module cannot.
+     * @param settings Settings of the durable regions, with an empty path for volatile regions
+    **/
+    void set_durable(Durable settings) {
+        if (unlikely(!settings.path.empty() && !tm_create_durable))
+            throw Exception::ModuleDurable{};
+        durable = ::std::move(settings);
+    }
+};
+
+/** Observer of the operations on a shared memory region, e.g. to record them.
+**/
+class TransactionalTracer {
+public:
+    /** Traced operation enum class.
+    **/
+    enum class Op: uint8_t {
+        begin_ro,
+        begin_rw,
+        read,
+        read_range,
+        write,
+        alloc,
+        free,
+        end
+    };
+public:
+    /** Virtual destructor.
+    **/
+    virtual ~TransactionalTracer() {};
+public:
+    /** [thread-safe] Observe one operation, once the library returned.
+     * @param op      Operation
+     * @param address Shared address accessed, allocated or freed ('nullptr' for begin and end)
+     * @param size    Size accessed or allocated (in bytes, 0 for the other operations)
+     * @param success Whether the operation succeeded (the transaction can continue, or began or committed)
+    **/
+    virtual void trace(Op op, void const* address, size_t size, bool success) noexcept = 0;
 };
 
 /** One shared memory region management class.
@@ -163,17 +301,22 @@ private:
     void*  start_addr; // Shared memory region first segment's start address
     size_t start_size; // Shared memory region first segment's size (in bytes)
     size_t alignment;  // Shared memory region alignment (in bytes)
+    TransactionalTracer* tracer; // Observer of every operation, 'nullptr' for none
 public:
     /** Bind constructor.
-     * @param library Transactional library to use
+     * @param library Transactional library to use, creating a durable region if set so
      * @param align   Shared memory region required alignment
      * @param size    Size of the shared memory region to allocate
     **/
-    TransactionalMemory(TransactionalLibrary const& library, size_t align, size_t size): tl{library}, start_size{size}, alignment{align} {
+    TransactionalMemory(TransactionalLibrary const& library, size_t align, size_t size): tl{library}, start_size{size}, alignment{align}, tracer{nullptr} {
         if (unlikely(assert_mode && (!is_power_of_two(align) || size % align != 0)))
             throw Exception::TransactionAlign{};
         bounded_run(max_side_time, [&]() {
-            shared = tl.tm_create(size, align);
+            if (tl.durable.path.empty()) {
+                shared = tl.tm_create(size, align);
+            } else {
+                shared = tl.tm_create_durable(size, align, tl.durable.path.c_str(), tl.durable.latency_us, tl.durable.capacity, true);
+            }
             if (unlikely(shared == STM::invalid_shared))
                 throw Exception::TransactionCreate{};
             start_addr = tl.tm_start(shared);
@@ -205,22 +348,64 @@ public:
     auto get_align() const noexcept {
         return alignment;
     }
+    /** Set the observer of every following operation, with no transaction running.
+     * @param tracer Observer to use, 'nullptr' for none
+    **/
+    void set_tracer(TransactionalTracer* tracer) noexcept {
+        this->tracer = tracer;
+    }
+    /** [thread-safe] Get the library's statistics of the shared memory region, if the library provides any.
+     * @return Named statistics, empty if none
+    **/
+    auto get_stats() const {
+        ::std::vector<::std::pair<::std::string, uint64_t>> res;
+        if (!tl.tm_stats)
+            return res;
+        ::std::vector<STM::tm_ext_stat> stats(16);
+        auto count = tl.tm_stats(shared, stats.data(), stats.size());
+        if (count > stats.size()) {
+            stats.resize(count);
+            count = ::std::min(count, tl.tm_stats(shared, stats.data(), stats.size()));
+        }
+        for (size_t i = 0; i < count; ++i)
+            res.emplace_back(stats[i].name, stats[i].value);
+        return res;
+    }
+public:
+    /** [thread-safe] Prepare the calling thread to run transactions on the shared memory region, before its first one.
+    **/
+    void thread_init() const noexcept {
+        if (tl.tm_thread_init)
+            tl.tm_thread_init(shared);
+    }
+    /** [thread-safe] Release what the calling thread holds for the shared memory region, after its last transaction.
+    **/
+    void thread_fini() const noexcept {
+        if (tl.tm_thread_fini)
+            tl.tm_thread_fini(shared);
+    }
 public:
     /** [thread-safe] Begin a new transaction on the shared memory region.
      * @param ro Whether the transaction is read-only
      * @return Opaque transaction ID, 'STM::invalid_tx' on failure
     **/
     auto begin(bool ro) const noexcept {
-        return tl.tm_begin(shared, ro);
+        auto res = tl.tm_begin(shared, ro);
+        if (unlikely(tracer))
+            tracer->trace(ro ? TransactionalTracer::Op::begin_ro : TransactionalTracer::Op::begin_rw, nullptr, 0, res != STM::invalid_tx);
+        return res;
     }
     /** [thread-safe] End the given transaction.
      * @param tx Opaque transaction ID
      * @return Whether the whole transaction is a success
     **/
     auto end(TX tx) const noexcept {
-        return tl.tm_end(shared, tx);
+        auto res = tl.tm_end(shared, tx);
+        if (unlikely(tracer))
+            tracer->trace(TransactionalTracer::Op::end, nullptr, 0, res);
+        return res;
     }
-    /** [thread-safe] Read operation in the given transaction, source in the shared region and target in a private region.
+    /** [thread-safe] Read operation in the given transaction, source in the shared region and target in a private region, using the library's single-word read if provided.
      * @param tx     Transaction to use
      * @param source Source start address
      * @param size   Source/target range
@@ -228,9 +413,25 @@ public:
      * @return Whether the whole transaction can continue
     **/
     auto read(TX tx, void const* source, size_t size, void* target) const noexcept {
-        return tl.tm_read(shared, tx, source, size, target);
+        auto res = size == alignment && tl.tm_read_word ? tl.tm_read_word(shared, tx, source, target) : tl.tm_read(shared, tx, source, size, target);
+        if (unlikely(tracer))
+            tracer->trace(TransactionalTracer::Op::read, source, size, res);
+        return res;
+    }
+    /** [thread-safe] Bulk read operation in the given transaction, using the library's range read if exported.
+     * @param tx     Transaction to use
+     * @param source Source start address
+     * @param size   Source/target range
+     * @param target Target start address
+     * @return Whether the whole transaction can continue
+    **/
+    auto read_range(TX tx, void const* source, size_t size, void* target) const noexcept {
+        auto res = tl.tm_read_range ? tl.tm_read_range(shared, tx, source, size, target) : tl.tm_read(shared, tx, source, size, target);
+        if (unlikely(tracer))
+            tracer->trace(TransactionalTracer::Op::read_range, source, size, res);
+        return res;
     }
-    /** [thread-safe] Write operation in the given transaction, source in a private region and target in the shared region.
+    /** [thread-safe] Write operation in the given transaction, source in a private region and target in the shared region, using the library's single-word write if provided.
      * @param tx     Transaction to use
      * @param source Source start address
      * @param size   Source/target range
@@ -238,7 +439,26 @@ public:
      * @return Whether the whole transaction can continue
     **/
     auto write(TX tx, void const* source, size_t size, void* target) const noexcept {
-        return tl.tm_write(shared, tx, source, size, target);
+        auto res = size == alignment && tl.tm_write_word ? tl.tm_write_word(shared, tx, source, target) : tl.tm_write(shared, tx, source, size, target);
+        if (unlikely(tracer))
+            tracer->trace(TransactionalTracer::Op::write, target, size, res);
+        return res;
+    }
+    /** [thread-safe] Addition to one 64-bit word in the given transaction, without reading it if the library can.
+     * Traced as the equivalent read and write, which a replay then runs.
+     * @param tx     Transaction to use
+     * @param delta  Value to add (wrapping around)
+     * @param target Target word address
+     * @return Whether the whole transaction can continue
+    **/
+    auto add(TX tx, int64_t delta, void* target) const noexcept {
+        if (tl.tm_add && alignment == sizeof(int64_t) && !tracer)
+            return tl.tm_add(shared, tx, target, delta);
+        uint64_t value;
+        if (!read(tx, target, sizeof(value), &value))
+            return false;
+        value += static_cast<uint64_t>(delta);
+        return write(tx, &value, sizeof(value), target);
     }
     /** [thread-safe] Memory allocation operation in the given transaction, throw if no memory available.
      * @param tx     Transaction to use
@@ -247,7 +467,10 @@ public:
      * @return Allocation status
     **/
     auto alloc(TX tx, size_t size, void** target) const noexcept {
-        return tl.tm_alloc(shared, tx, size, target);
+        auto res = tl.tm_alloc(shared, tx, size, target);
+        if (unlikely(tracer))
+            tracer->trace(TransactionalTracer::Op::alloc, res == STM::Alloc::success ? *target : nullptr, size, res == STM::Alloc::success);
+        return res;
     }
     /** [thread-safe] Memory freeing operation in the given transaction.
      * @param tx     Transaction to use
@@ -255,7 +478,51 @@ public:
      * @return Whether the whole transaction can continue
     **/
     auto free(TX tx, void* target) const noexcept {
-        return tl.tm_free(shared, tx, target);
+        auto res = tl.tm_free(shared, tx, target);
+        if (unlikely(tracer))
+            tracer->trace(TransactionalTracer::Op::free, target, 0, res);
+        return res;
+    }
+    /** [thread-safe] Check whether the library provides voluntary aborts, i.e. whether 'abort' can discard writes.
+     * @return Whether it does
+    **/
+    bool has_abort() const noexcept {
+        return tl.tm_abort;
+    }
+    /** [thread-safe] End the given transaction on purpose, without committing it if the library can.
+     * Without the library's voluntary abort, the transaction is ended normally, i.e. its writes (if any) commit.
+     * @param tx Transaction to abort
+     * @return Whether its writes were discarded
+    **/
+    auto abort(TX tx) const noexcept {
+        auto res = false;
+        if (tl.tm_abort) {
+            res = tl.tm_abort(shared, tx);
+        } else {
+            tl.tm_end(shared, tx);
+        }
+        if (unlikely(tracer)) // Recorded as a failed end, so that replays skip it
+            tracer->trace(TransactionalTracer::Op::end, nullptr, 0, false);
+        return res;
+    }
+};
+
+/** Scope of the calling thread's use of a shared memory region, calling the library's thread hooks.
+**/
+class TransactionalThread final: private NonCopyable {
+private:
+    TransactionalMemory const& tm; // Bound transactional memory
+public:
+    /** Thread preparation constructor.
+     * @param tm Transactional memory the calling thread is about to use
+    **/
+    TransactionalThread(TransactionalMemory const& tm) noexcept: tm{tm} {
+        tm.thread_init();
+    }
+    /** Thread release destructor.
+    **/
+    ~TransactionalThread() noexcept {
+        tm.thread_fini();
     }
 };
 
@@ -273,7 +540,9 @@ private:
     TransactionalMemory const& tm; // Bound transactional memory
     STM::tx_t tx; // Opaque transaction handle
     bool aborted; // Transaction was aborted
+    bool ended;   // Transaction was ended with 'commit'
     bool is_ro;   // Whether the transaction is read-only (solely for assertion)
+    bool written; // Whether the transaction wrote, allocated or freed (so that only the library could discard it)
 public:
     /** Deleted copy constructor/assignment.
     **/
@@ -283,14 +552,14 @@ public:
      * @param tm Transactional memory to bind
      * @param ro Whether the transaction is read-only
     **/
-    Transaction(TransactionalMemory const& tm, Mode ro): tm{tm}, tx{tm.begin(static_cast<bool>(ro))}, aborted{false}, is_ro{static_cast<bool>(ro)} {
+    Transaction(TransactionalMemory const& tm, Mode ro): tm{tm}, tx{tm.begin(static_cast<bool>(ro))}, aborted{false}, ended{false}, is_ro{static_cast<bool>(ro)}, written{false} {
         if (unlikely(tx == STM::invalid_tx))
             throw Exception::TransactionBegin{};
     }
-    /** End destructor.
+    /** End destructor, unless aborted or ended with 'commit'.
     **/
     ~Transaction() noexcept(false) {
-        if (likely(!aborted)) {
+        if (likely(!aborted && !ended)) {
             if (unlikely(!tm.end(tx)))
                 throw Exception::TransactionRetry{};
         }
@@ -309,10 +578,17 @@ public:
      * @param target Target start address
     **/
     void read(void const* source, size_t size, void* target) {
-        if (unlikely(!tm.read(tx, source, size, target))) {
-            aborted = true;
+        if (unlikely(!try_read(source, size, target)))
+            throw Exception::TransactionRetry{};
+    }
+    /** [thread-safe] Bulk read operation in the bound transaction, source in the shared region and target in a private region.
+     * @param source Source start address
+     * @param size   Source/target range
+     * @param target Target start address
+    **/
+    void read_range(void const* source, size_t size, void* target) {
+        if (unlikely(!try_read_range(source, size, target)))
             throw Exception::TransactionRetry{};
-        }
     }
     /** [thread-safe] Write operation in the bound transaction, source in a private region and target in the shared region.
      * @param source Source start address
@@ -320,28 +596,29 @@ public:
      * @param target Target start address
     **/
     void write(void const* source, size_t size, void* target) {
-        if (unlikely(assert_mode && is_ro))
-            throw Exception::TransactionReadOnly{};
-        if (unlikely(!tm.write(tx, source, size, target))) {
-            aborted = true;
+        if (unlikely(!try_write(source, size, target)))
+            throw Exception::TransactionRetry{};
+    }
+    /** [thread-safe] Addition operation in the bound transaction, to one 64-bit word in the shared region.
+     * @param delta  Value to add (wrapping around)
+     * @param target Target word address
+    **/
+    void add(int64_t delta, void* target) {
+        if (unlikely(!try_add(delta, target)))
             throw Exception::TransactionRetry{};
-        }
     }
     /** [thread-safe] Memory allocation operation in the bound transaction, throw if no memory available.
      * @param size Size to allocate
      * @return Target start address
     **/
     void* alloc(size_t size) {
-        if (unlikely(assert_mode && is_ro))
-            throw Exception::TransactionReadOnly{};
         void* target;
-        switch (tm.alloc(tx, size, &target)) {
+        switch (try_alloc(size, &target)) {
         case STM::Alloc::success:
             return target;
         case STM::Alloc::nomem:
             throw Exception::TransactionAlloc{};
         default: // STM::Alloc::abort
-            aborted = true;
             throw Exception::TransactionRetry{};
         }
     }
@@ -349,12 +626,126 @@ public:
      * @param target Target start address
     **/
     void free(void* target) {
+        if (unlikely(!try_free(target)))
+            throw Exception::TransactionRetry{};
+    }
+public:
+    // Status-returning operations, which do not throw on abort: once one returns false, the transaction is over.
+
+    /** [thread-safe] Read operation in the bound transaction, source in the shared region and target in a private region.
+     * @param source Source start address
+     * @param size   Source/target range
+     * @param target Target start address
+     * @return Whether the transaction can continue
+    **/
+    [[nodiscard]] bool try_read(void const* source, size_t size, void* target) noexcept {
+        if (unlikely(!tm.read(tx, source, size, target))) {
+            aborted = true;
+            return false;
+        }
+        return true;
+    }
+    /** [thread-safe] Bulk read operation in the bound transaction, source in the shared region and target in a private region.
+     * @param source Source start address
+     * @param size   Source/target range
+     * @param target Target start address
+     * @return Whether the transaction can continue
+    **/
+    [[nodiscard]] bool try_read_range(void const* source, size_t size, void* target) noexcept {
+        if (unlikely(!tm.read_range(tx, source, size, target))) {
+            aborted = true;
+            return false;
+        }
+        return true;
+    }
+    /** [thread-safe] Write operation in the bound transaction, source in a private region and target in the shared region.
+     * @param source Source start address
+     * @param size   Source/target range
+     * @param target Target start address
+     * @return Whether the transaction can continue
+    **/
+    [[nodiscard]] bool try_write(void const* source, size_t size, void* target) {
+        if (unlikely(assert_mode && is_ro))
+            throw Exception::TransactionReadOnly{};
+        if (unlikely(!tm.write(tx, source, size, target))) {
+            aborted = true;
+            return false;
+        }
+        written = true;
+        return true;
+    }
+    /** [thread-safe] Addition operation in the bound transaction, to one 64-bit word in the shared region.
+     * @param delta  Value to add (wrapping around)
+     * @param target Target word address
+     * @return Whether the transaction can continue
+    **/
+    [[nodiscard]] bool try_add(int64_t delta, void* target) {
+        if (unlikely(assert_mode && is_ro))
+            throw Exception::TransactionReadOnly{};
+        if (unlikely(!tm.add(tx, delta, target))) {
+            aborted = true;
+            return false;
+        }
+        written = true;
+        return true;
+    }
+    /** [thread-safe] Memory allocation operation in the bound transaction.
+     * @param size   Size to allocate
+     * @param target Pointer in private memory receiving the address of the first byte of the newly allocated, aligned segment
+     * @return Whether the allocation succeeded, the transaction can continue without memory, or it was aborted
+    **/
+    [[nodiscard]] STM::Alloc try_alloc(size_t size, void** target) {
+        if (unlikely(assert_mode && is_ro))
+            throw Exception::TransactionReadOnly{};
+        auto res = tm.alloc(tx, size, target);
+        if (unlikely(res == STM::Alloc::abort))
+            aborted = true;
+        if (res == STM::Alloc::success)
+            written = true;
+        return res;
+    }
+    /** [thread-safe] Memory freeing operation in the bound transaction.
+     * @param target Target start address
+     * @return Whether the transaction can continue
+    **/
+    [[nodiscard]] bool try_free(void* target) {
         if (unlikely(assert_mode && is_ro))
             throw Exception::TransactionReadOnly{};
         if (unlikely(!tm.free(tx, target))) {
             aborted = true;
-            throw Exception::TransactionRetry{};
+            return false;
+        }
+        written = true;
+        return true;
+    }
+    /** [thread-safe] End the bound transaction now, instead of at destruction.
+     * @return Whether the transaction committed
+    **/
+    [[nodiscard]] bool commit() noexcept {
+        ended = true;
+        if (unlikely(!tm.end(tx))) {
+            aborted = true;
+            return false;
         }
+        return true;
+    }
+    /** [thread-safe] Give up the bound transaction now, without committing it if the library can (see 'TransactionalMemory::abort').
+     * Without the library's voluntary abort, only a transaction that did not write, allocate nor free yet can be given up:
+     * otherwise it is ended (the only way left, committing what it did) and 'Exception::TransactionGiveUp' is thrown.
+     * @return Whether its writes were discarded
+    **/
+    bool abort() {
+        ended = true;
+        auto res = tm.abort(tx);
+        if (unlikely(written && !tm.has_abort()))
+            throw Exception::TransactionGiveUp{};
+        return res;
+    }
+    /** [thread-safe] Tell whether the bound transaction was aborted by the library.
+     * @return Whether an operation or the commit aborted
+    **/
+    bool is_aborted() const noexcept {
+        return aborted;
     }
 };
 
@@ -406,6 +797,13 @@ public:
     void operator=(Type const& source) const {
         return write(source);
     }
+    /** Addition operation, without reading the content if the library can, for 64-bit integers only.
+     * @param delta Value to add (wrapping around)
+    **/
+    void add(int64_t delta) const {
+        static_assert(::std::is_integral_v<Type> && sizeof(Type) == sizeof(int64_t), "additions are to 64-bit integers");
+        tx.add(delta, address);
+    }
 public:
     /** Address of the first byte after the entry.
      * @return First byte after the entry
@@ -516,12 +914,30 @@ public:
         tx.read(address + index, sizeof(Type), &res);
         return res;
     }
+    /** Range read operation.
+     * @param index  Index of the first element to read
+     * @param count  Number of elements to read
+     * @param target Private array receiving the elements
+    **/
+    void read_range(size_t index, size_t count, Type* target) const {
+        if (count > 0)
+            tx.read_range(address + index, count * sizeof(Type), target);
+    }
     /** Write operation.
      * @param index  Index to write
      * @param source Private content to write at the shared address
     **/
     void write(size_t index, Type const& source) const {
-        tx.write(tx, &source, sizeof(Type), address + index);
+        tx.write(&source, sizeof(Type), address + index);
+    }
+    /** Range write operation.
+     * @param index  Index of the first element to write
+     * @param count  Number of elements to write
+     * @param source Private array of the elements to write
+    **/
+    void write_range(size_t index, size_t count, Type const* source) const {
+        if (count > 0)
+            tx.write(source, count * sizeof(Type), address + index);
     }
 public:
     /** Reference a cell.
@@ -573,6 +989,17 @@ public:
         tx.read(address + index, sizeof(Type), &res);
         return res;
     }
+    /** Range read operation.
+     * @param index  Index of the first element to read
+     * @param count  Number of elements to read
+     * @param target Private array receiving the elements
+    **/
+    void read_range(size_t index, size_t count, Type* target) const {
+        if (unlikely(assert_mode && index + count > n))
+            throw Exception::SharedOverflow{};
+        if (count > 0)
+            tx.read_range(address + index, count * sizeof(Type), target);
+    }
     /** Write operation.
      * @param index  Index to write
      * @param source Private content to write at the shared address
@@ -580,7 +1007,18 @@ public:
     void write(size_t index, Type const& source) const {
         if (unlikely(assert_mode && index >= n))
             throw Exception::SharedOverflow{};
-        tx.write(tx, &source, sizeof(Type), address + index);
+        tx.write(&source, sizeof(Type), address + index);
+    }
+    /** Range write operation.
+     * @param index  Index of the first element to write
+     * @param count  Number of elements to write
+     * @param source Private array of the elements to write
+    **/
+    void write_range(size_t index, size_t count, Type const* source) const {
+        if (unlikely(assert_mode && index + count > n))
+            throw Exception::SharedOverflow{};
+        if (count > 0)
+            tx.write(source, count * sizeof(Type), address + index);
     }
 public:
     /** Reference a cell.
@@ -602,19 +1040,122 @@ public:
 
 // -------------------------------------------------------------------------- //
 
-/** Repeat a given transaction until it commits.
- * @param tm   Transactional memory
- * @param mode Transactional mode
- * @param func Transaction closure (Transaction& -> ...)
+/** Per-thread transaction counters, maintained by 'transactional'.
+**/
+struct TransactionCounters final {
+    uint_fast64_t attempts = 0; // Transactions begun
+    uint_fast64_t retries  = 0; // Transactions aborted, then begun again
+};
+inline thread_local TransactionCounters transaction_counters;
+
+/** Policy of waiting between the attempts of an aborted transaction.
+**/
+class RetryPolicy final {
+public:
+    /** Policy kind enum class.
+    **/
+    enum class Kind {
+        immediate,   // Retry at once
+        backoff,     // Spin for an exponentially growing, randomized number of pauses
+        spin_yield   // Retry at once a bounded number of times, then yield the CPU before each attempt
+    };
+private:
+    Kind   kind;  // Policy kind
+    size_t bound; // Largest number of pauses ('backoff') or of immediate retries ('spin_yield')
+public:
+    /** Policy constructor.
+     * @param kind  Policy kind
+     * @param bound Largest number of pauses ('backoff') or of immediate retries ('spin_yield')
+    **/
+    constexpr RetryPolicy(Kind kind = Kind::immediate, size_t bound = 1024) noexcept: kind{kind}, bound{bound} {}
+public:
+    /** Get the policy kind.
+     * @return Policy kind
+    **/
+    auto get_kind() const noexcept {
+        return kind;
+    }
+    /** Wait before the next attempt.
+     * @param retries Number of retries so far (0 before the first retry)
+    **/
+    void wait(size_t retries) const noexcept {
+        switch (kind) {
+        case Kind::immediate:
+            return;
+        case Kind::backoff: {
+            thread_local uint_fast32_t state = 0x9e3779b9u ^ static_cast<uint_fast32_t>(reinterpret_cast<uintptr_t>(&state)); // Per-thread xorshift state
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            auto limit = ::std::min<size_t>(bound, size_t{1} << ::std::min<size_t>(retries, 20));
+            for (auto count = (state & 0xffffffffu) % limit + 1; count > 0; --count)
+                short_pause();
+        } return;
+        default: // Kind::spin_yield
+            if (retries >= bound)
+                ::std::this_thread::yield();
+            return;
+        }
+    }
+};
+
+/** Retry policy of 'transactional' when none is given, to set before the workers start.
+**/
+inline RetryPolicy default_retry_policy;
+
+/** Repeat a given transaction until it commits, the closure throwing 'Exception::TransactionRetry' on abort.
+ * @param tm     Transactional memory
+ * @param mode   Transactional mode
+ * @param policy Policy of waiting between attempts
+ * @param func   Transaction closure (Transaction& -> ...)
  * @return Returned value (or void) when the transaction committed
 **/
-template<class Func> static auto transactional(TransactionalMemory const& tm, Transaction::Mode mode, Func&& func) {
-    do {
+template<class Func> static auto transactional(TransactionalMemory const& tm, Transaction::Mode mode, RetryPolicy const& policy, Func&& func) {
+    for (size_t retries = 0; ; ++retries) {
         try {
+            ++transaction_counters.attempts;
             Transaction tx{tm, mode};
             return func(tx);
         } catch (Exception::TransactionRetry const&) {
-            continue;
+            ++transaction_counters.retries;
+            policy.wait(retries);
+        }
+    }
+}
+
+/** Repeat a given transaction until it commits, the closure throwing 'Exception::TransactionRetry' on abort.
+ * @param tm   Transactional memory
+ * @param mode Transactional mode
+ * @param func Transaction closure (Transaction& -> ...)
+ * @return Returned value (or void) when the transaction committed
+**/
+template<class Func> static auto transactional(TransactionalMemory const& tm, Transaction::Mode mode, Func&& func) {
+    return transactional(tm, mode, default_retry_policy, ::std::forward<Func>(func));
+}
+
+/** Repeat a given transaction until it commits, without exceptions on abort.
+ * The closure uses the status-returning operations ('Transaction::try_*'), and returns false as soon as one does.
+ * It may also return false on its own (e.g. after 'Transaction::try_alloc' found no memory): the transaction is
+ * then given up with 'Transaction::abort' and not retried, only library aborts being retried. Unless the library
+ * provides voluntary aborts, the closure must give up before its first write, allocation or freeing.
+ * @param tm     Transactional memory
+ * @param mode   Transactional mode
+ * @param policy Policy of waiting between attempts
+ * @param func   Transaction closure (Transaction& -> bool), returning whether the transaction can continue
+ * @return Whether the transaction committed, false if the closure gave up
+**/
+template<class Func> static bool transactional_try(TransactionalMemory const& tm, Transaction::Mode mode, RetryPolicy const& policy, Func&& func) {
+    for (size_t retries = 0; ; ++retries) {
+        ++transaction_counters.attempts;
+        Transaction tx{tm, mode};
+        if (likely(func(tx))) {
+            if (likely(tx.commit()))
+                return true;
+        } else if (!tx.is_aborted()) { // Given up by the closure
+            tx.abort();
+            return false;
         }
-    } while (true);
+        ++transaction_counters.retries;
+        policy.wait(retries);
+    }
 }
@@ -24,8 +24,18 @@
 #pragma once
 
 // External headers
+#include <algorithm>
+#include <atomic>
+#include <cmath>
 #include <cstdint>
+#include <initializer_list>
+#include <limits>
+#include <mutex>
 #include <random>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
 // Internal headers
 #include "common.hpp"
@@ -40,6 +50,74 @@ using Uid = uint_fast32_t;
 **/
 using Seed = uint_fast32_t;
 
+/** Latency and retry distributions of one type of transaction.
+**/
+struct TransactionStats final {
+    ::std::string name; // Transaction type name
+    Histogram latency;  // Execution time of each transaction, retries included (in ns)
+    Histogram retries;  // Number of retries of each transaction
+    /** Add the transactions recorded by other statistics of the same type.
+     * @param other Statistics to merge in
+    **/
+    void merge(TransactionStats const& other) noexcept {
+        latency.merge(other.latency);
+        retries.merge(other.retries);
+    }
+};
+
+/** Per-worker statistics recorder of several types of transaction.
+**/
+class TransactionRecorder final {
+private:
+    ::std::vector<char const*> names; // Name of each transaction type
+    ::std::vector<TransactionStats> stats; // Per-worker statistics (one entry per type and per worker)
+public:
+    /** Recorder constructor.
+     * @param nbworkers Number of workers
+     * @param names     Name of each transaction type
+    **/
+    TransactionRecorder(size_t nbworkers, ::std::initializer_list<char const*> names): names{names}, stats(nbworkers * names.size()) {}
+public:
+    /** [thread-safe] Run one (retried) transaction, and record its execution time and number of retries.
+     * @param uid  Unique ID of the calling worker
+     * @param type Transaction type index
+     * @param func Function running the transaction (void -> ?)
+     * @return Returned value of the function
+    **/
+    template<class Func> decltype(auto) record(Uid uid, size_t type, Func&& func) {
+        auto& local = stats[uid * names.size() + type];
+        auto retries = transaction_counters.retries;
+        Chrono chrono;
+        chrono.start();
+        auto done = [&]() {
+            local.latency.record(chrono.delta());
+            local.retries.record(transaction_counters.retries - retries);
+        };
+        if constexpr (::std::is_void_v<decltype(func())>) {
+            func();
+            done();
+        } else {
+            auto res = func();
+            done();
+            return res;
+        }
+    }
+    /** [thread-safe] Take the statistics of a worker since the last call.
+     * @param uid Unique ID of the worker
+     * @return Statistics of each transaction type
+    **/
+    ::std::vector<TransactionStats> take(Uid uid) {
+        ::std::vector<TransactionStats> res(names.size());
+        for (size_t type = 0; type < names.size(); ++type) {
+            auto& local = stats[uid * names.size() + type];
+            res[type].name = names[type];
+            res[type].merge(local);
+            local = TransactionStats{};
+        }
+        return res;
+    }
+};
+
 /** Workload base class.
 **/
 class Workload {
@@ -61,6 +139,12 @@ public:
     **/
     virtual ~Workload() {};
 public:
+    /** Get the built transactional memory, e.g. to trace its operations.
+     * @return Built transactional memory
+    **/
+    TransactionalMemory& get_tm() noexcept {
+        return tm;
+    }
     /** Shared memory (re)initialization.
      * @return Constant null-terminated error message, 'nullptr' for none
     **/
@@ -77,6 +161,19 @@ public:
      * @return Constant null-terminated error message, 'nullptr' for none
     **/
     virtual char const* check(Uid, Seed) const = 0;
+    /** Take the number of transactions committed by the workers' runs since the last call.
+     * @return Number of committed transactions, 0 if not tracked
+    **/
+    virtual size_t take_committed() {
+        return 0;
+    }
+    /** [thread-safe] Take the per-type transaction statistics of a worker's runs since the last call.
+     * @param Unique ID of the worker (between 0 to n-1)
+     * @return Statistics of each transaction type, the same types in the same order at each call, empty if not tracked
+    **/
+    virtual ::std::vector<TransactionStats> take_stats(Uid) {
+        return {};
+    }
 };
 
 // -------------------------------------------------------------------------- //
@@ -140,7 +237,11 @@ private:
     Balance init_balance;  // Initial account balance
     float   prob_long;     // Probability of running a long, read-only control transaction
     float   prob_alloc;    // Probability of running an allocation/deallocation transaction, knowing a long transaction won't run
+    Chrono::Tick duration; // Duration of a run (in ns), 0 to run 'nbtxperwrk' transactions per worker instead
+    bool    batched;       // Whether to scan and initialize the accounts with range accesses, instead of per-account accesses
     Barrier barrier;       // Barrier for thread synchronization during 'check'
+    ::std::atomic<size_t> mutable committed; // Transactions committed by the runs since the last 'take_committed'
+    TransactionRecorder mutable recorder; // Per-worker statistics of the long, short and allocation transactions
 public:
     /** Bank workload constructor.
      * @param library       Transactional library to use
@@ -151,14 +252,17 @@ public:
      * @param init_balance  Initial account balance
      * @param prob_long     Probability of running a long, read-only control transaction
      * @param prob_alloc    Probability of running an allocation/deallocation transaction, knowing a long transaction won't run
+     * @param duration      Duration of a run (in ns), 0 to run 'nbtxperwrk' transactions per worker instead
+     * @param batched       Whether to scan and initialize the accounts with range accesses, instead of per-account accesses
     **/
-    WorkloadBank(TransactionalLibrary const& library, size_t nbworkers, size_t nbtxperwrk, size_t nbaccounts, size_t expnbaccounts, Balance init_balance, float prob_long, float prob_alloc): Workload{library, AccountSegment::align(), AccountSegment::size(nbaccounts)}, nbworkers{nbworkers}, nbtxperwrk{nbtxperwrk}, nbaccounts{nbaccounts}, expnbaccounts{expnbaccounts}, init_balance{init_balance}, prob_long{prob_long}, prob_alloc{prob_alloc}, barrier{static_cast<Barrier::Counter>(nbworkers)} {}
+    WorkloadBank(TransactionalLibrary const& library, size_t nbworkers, size_t nbtxperwrk, size_t nbaccounts, size_t expnbaccounts, Balance init_balance, float prob_long, float prob_alloc, Chrono::Tick duration = 0, bool batched = false): Workload{library, AccountSegment::align(), AccountSegment::size(nbaccounts)}, nbworkers{nbworkers}, nbtxperwrk{nbtxperwrk}, nbaccounts{nbaccounts}, expnbaccounts{expnbaccounts}, init_balance{init_balance}, prob_long{prob_long}, prob_alloc{prob_alloc}, duration{duration}, batched{batched}, barrier{static_cast<Barrier::Counter>(nbworkers)}, committed{0}, recorder{nbworkers, {"long", "short", "alloc"}} {}
 private:
     /** Long read-only transaction, summing the balance of each account.
      * @param count Loosely-updated number of accounts
      * @return Whether no inconsistency has been found
     **/
     bool long_tx(size_t& nbaccounts) const {
+        ::std::vector<Balance> balances; // Private copy of a segment's accounts, kept across retries.
         return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
             auto count = 0ul; // Total number of accounts seen.
             auto sum   = Balance{0}; // Total balance on all seen accounts + parity ammount.
@@ -168,11 +272,21 @@ private:
                 decltype(count) segment_count = segment.count;
                 count += segment_count; // And accumulate the total number of accounts.
                 sum += segment.parity; // We also sum the money that results from the destruction of accounts.
-                for (decltype(count) i = 0; i < segment_count; ++i) {
-                    Balance local = segment.accounts[i];
-                    if (unlikely(local < 0)) // If one account has a negative balance, there's a consistency issue.
-                        return false;
-                    sum += local;
+                if (batched) {
+                    balances.resize(segment_count);
+                    segment.accounts.read_range(0, segment_count, balances.data()); // The whole segment is scanned at once.
+                    for (auto local: balances) {
+                        if (unlikely(local < 0)) // If one account has a negative balance, there's a consistency issue.
+                            return false;
+                        sum += local;
+                    }
+                } else {
+                    for (decltype(count) i = 0; i < segment_count; ++i) {
+                        Balance local = segment.accounts[i];
+                        if (unlikely(local < 0)) // If one account has a negative balance, there's a consistency issue.
+                            return false;
+                        sum += local;
+                    }
                 }
                 start = segment.next; // Accounts are stored in linked segments, we move to the next one.
             }
@@ -278,11 +392,16 @@ public:
      * Initialize the first segment of accounts and check the initial ballance (2 transactions).
     **/
     virtual char const* init() const {
+        ::std::vector<Balance> balances(batched ? nbaccounts : 0, init_balance);
         transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
             AccountSegment segment{tx, tm.get_start()};
             segment.count = nbaccounts;
-            for (size_t i = 0; i < nbaccounts; ++i)
-                segment.accounts[i] = init_balance;
+            if (batched) {
+                segment.accounts.write_range(0, nbaccounts, balances.data());
+            } else {
+                for (size_t i = 0; i < nbaccounts; ++i)
+                    segment.accounts.write(i, init_balance);
+            }
         });
         auto correct = transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
             AccountSegment segment{tx, tm.get_start()};
@@ -294,24 +413,33 @@ public:
     }
 
     /**
-     * Run nbtxperwrk random transactions until completion.
+     * Run nbtxperwrk random transactions until completion, or as many as possible during the run duration.
      * @param seed Randomness source
     **/
-    virtual char const* run(Uid uid [[gnu::unused]], Seed seed) const {
+    virtual char const* run(Uid uid, Seed seed) const {
         ::std::minstd_rand engine{seed};
         ::std::bernoulli_distribution long_dist{prob_long};
         ::std::bernoulli_distribution alloc_dist{prob_alloc};
         ::std::gamma_distribution<float> alloc_trigger(expnbaccounts, 1);
         size_t count = nbaccounts;
-        for (size_t cntr = 0; cntr < nbtxperwrk; ++cntr) {
+        Chrono elapsed;
+        elapsed.start();
+        size_t cntr = 0;
+        for (; duration > 0 ? elapsed.delta() < duration : cntr < nbtxperwrk; ++cntr) {
             if (long_dist(engine)) { // We roll a dice and, if "lucky", run a long transaction.
-                if (unlikely(!long_tx(count))) // If it fails, then we return an error message.
+                if (unlikely(!recorder.record(uid, 0, [&]() { return long_tx(count); }))) // If it fails, then we return an error message.
                     return "Violated isolation or atomicity";
             } else if (alloc_dist(engine)) { // Let's roll a dice again to trigger an allocation transaction.
-                alloc_tx(alloc_trigger(engine));
+                auto trigger = alloc_trigger(engine);
+                recorder.record(uid, 2, [&]() { alloc_tx(trigger); });
             } else { // No luck with previous rolls, let's just run a short transaction.
                 ::std::uniform_int_distribution<size_t> account{0, count - 1};
-                while (unlikely(!short_tx(account(engine), account(engine))));
+                while (true) {
+                    auto send_id = account(engine);
+                    auto recv_id = account(engine);
+                    if (likely(recorder.record(uid, 1, [&]() { return short_tx(send_id, recv_id); })))
+                        break;
+                }
             }
         }
         { // Last long transaction
@@ -319,8 +447,15 @@ public:
             if (!long_tx(dummy))
                 return "Violated isolation or atomicity";
         }
+        committed.fetch_add(cntr + 1, ::std::memory_order_relaxed);
         return nullptr;
     }
+    virtual size_t take_committed() {
+        return committed.exchange(0, ::std::memory_order_relaxed);
+    }
+    virtual ::std::vector<TransactionStats> take_stats(Uid uid) {
+        return recorder.take(uid);
+    }
     /**
      * Test in which we check that multiple concurrent transactions can decrease a counter in a sequential manner.
      * @param uid Id of the thread to run the check
@@ -351,27 +486,25 @@ public:
 
         // In each thread,
         barrier.sync();
+        auto last = ::std::numeric_limits<size_t>::max();
         for (size_t i = 0; i < nbtxperwrk; ++i) {
 
-            // We first fetch the last value of the counter,
-            auto last = transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
+            // We first fetch the value of the counter, checking that it decreased since the last read (by our own decrement, at least),
+            auto value = transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
                 Shared<size_t> counter{tx, tm.get_start()};
                 return counter.read();
             });
-
-            // And then we decrease the value of the counter after checking that it didn't increase since the last read.
-            auto correct = transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
-                Shared<size_t> counter{tx, tm.get_start()};
-                auto value = counter.read();
-                if (unlikely(value > last))
-                    return false;
-                counter = value - 1;
-                return true;
-            });
-            if (unlikely(!correct)) {
+            if (unlikely(value >= last)) {
                 barrier.sync();
                 return "Violated consistency, isolation or atomicity";
             }
+            last = value;
+
+            // And then we decrease it, without reading it if the library can: concurrent decrements then need not conflict.
+            transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+                Shared<size_t> counter{tx, tm.get_start()};
+                counter.add(-1);
+            });
         }
 
         // Finally, a last transaction runs in the first thread to check that the counter reached 0 (i.e., each transaction decreased it by 1.).
@@ -387,3 +520,1892 @@ public:
         return nullptr;
     }
 };
+
+// -------------------------------------------------------------------------- //
+
+/** Integer set workload base class, running random lookups, insertions and removals on a transactional set.
+**/
+class WorkloadSet: public Workload {
+public:
+    /** Key class alias.
+    **/
+    using Key = uintptr_t;
+protected:
+    size_t nbworkers;     // Number of concurrent workers
+    size_t nbtxperwrk;    // Number of transactions per worker
+    size_t key_range;     // Keys are drawn from [0, key_range)
+    float  update_ratio;  // Probability of running an insertion or a removal (each equally likely), instead of a lookup
+    float  initial_fill;  // Ratio of the key range initially in the set
+    Chrono::Tick duration; // Duration of a run (in ns), 0 to run 'nbtxperwrk' transactions per worker instead
+    ::std::once_flag mutable filled; // The set is filled by only one of the workers
+    mutable char const* fill_error;  // Error message of the fill, 'nullptr' for none
+    ::std::atomic<size_t> mutable nbkeys; // Expected number of keys in the set
+    ::std::atomic<size_t> mutable committed; // Transactions committed by the runs since the last 'take_committed'
+    TransactionRecorder mutable recorder; // Per-worker statistics of the lookups, insertions and removals
+public:
+    /** Integer set workload constructor.
+     * @param library      Transactional library to use
+     * @param align        Shared memory region required alignment
+     * @param size         Size of the shared memory region to allocate
+     * @param nbworkers    Total number of concurrent threads
+     * @param nbtxperwrk   Number of transactions per worker
+     * @param key_range    Keys are drawn from [0, key_range)
+     * @param update_ratio Probability of running an insertion or a removal, instead of a lookup
+     * @param initial_fill Ratio of the key range initially in the set
+     * @param duration     Duration of a run (in ns), 0 to run 'nbtxperwrk' transactions per worker instead
+    **/
+    WorkloadSet(TransactionalLibrary const& library, size_t align, size_t size, size_t nbworkers, size_t nbtxperwrk, size_t key_range, float update_ratio, float initial_fill, Chrono::Tick duration): Workload{library, align, size}, nbworkers{nbworkers}, nbtxperwrk{nbtxperwrk}, key_range{key_range}, update_ratio{update_ratio}, initial_fill{initial_fill}, duration{duration}, fill_error{nullptr}, nbkeys{0}, committed{0}, recorder{nbworkers, {"lookup", "insert", "remove"}} {}
+protected:
+    /** [thread-safe] Lookup transaction.
+     * @param key Key to look for
+     * @return Whether the key is in the set
+    **/
+    virtual bool contains(Key key) const = 0;
+    /** [thread-safe] Insertion transaction.
+     * @param key Key to insert
+     * @return Whether the key was not in the set (and has been inserted)
+    **/
+    virtual bool insert(Key key) const = 0;
+    /** [thread-safe] Removal transaction.
+     * @param key Key to remove
+     * @return Whether the key was in the set (and has been removed)
+    **/
+    virtual bool remove(Key key) const = 0;
+    /** Check the structural invariants of the set, in one transaction.
+     * @param count Set to the number of keys in the set
+     * @return Constant null-terminated error message, 'nullptr' for none
+    **/
+    virtual char const* verify(size_t& count) const = 0;
+public:
+    /**
+     * Fill the set with a random subset of the key range, once for every worker.
+    **/
+    virtual char const* init() const {
+        ::std::call_once(filled, [&]() {
+            ::std::vector<Key> keys(key_range);
+            for (size_t i = 0; i < key_range; ++i)
+                keys[i] = i;
+            ::std::shuffle(keys.begin(), keys.end(), ::std::minstd_rand{});
+            keys.resize(static_cast<size_t>(initial_fill * static_cast<float>(key_range)));
+            for (auto key: keys) {
+                if (unlikely(!insert(key))) {
+                    fill_error = "Violated consistency (a key inserted once was found already in the set)";
+                    return;
+                }
+            }
+            nbkeys = keys.size();
+        });
+        return fill_error;
+    }
+    /**
+     * Run nbtxperwrk random operations until completion, or as many as possible during the run duration.
+     * @param uid  Unique ID of the worker
+     * @param seed Randomness source
+    **/
+    virtual char const* run(Uid uid, Seed seed) const {
+        ::std::minstd_rand engine{seed};
+        ::std::uniform_int_distribution<Key> key_dist{0, key_range - 1};
+        ::std::bernoulli_distribution update_dist{update_ratio};
+        ::std::bernoulli_distribution insert_dist{0.5};
+        Chrono elapsed;
+        elapsed.start();
+        size_t cntr = 0;
+        for (; duration > 0 ? elapsed.delta() < duration : cntr < nbtxperwrk; ++cntr) {
+            auto key = key_dist(engine);
+            if (!update_dist(engine)) {
+                recorder.record(uid, 0, [&]() { return contains(key); });
+            } else if (insert_dist(engine)) {
+                if (recorder.record(uid, 1, [&]() { return insert(key); }))
+                    nbkeys.fetch_add(1, ::std::memory_order_relaxed);
+            } else {
+                if (recorder.record(uid, 2, [&]() { return remove(key); }))
+                    nbkeys.fetch_sub(1, ::std::memory_order_relaxed);
+            }
+        }
+        committed.fetch_add(cntr, ::std::memory_order_relaxed);
+        return nullptr;
+    }
+    /**
+     * Check the structure of the set, and that its size matches the successful insertions and removals.
+     * @param uid Unique ID of the worker (only the first one checks)
+    **/
+    virtual char const* check(Uid uid, Seed seed [[gnu::unused]]) const {
+        if (uid != 0)
+            return nullptr;
+        size_t count = 0;
+        auto error = verify(count);
+        if (unlikely(error))
+            return error;
+        if (unlikely(count != nbkeys.load(::std::memory_order_relaxed)))
+            return "Violated isolation or atomicity (the set size does not match the successful insertions and removals)";
+        return nullptr;
+    }
+    virtual size_t take_committed() {
+        return committed.exchange(0, ::std::memory_order_relaxed);
+    }
+    virtual ::std::vector<TransactionStats> take_stats(Uid uid) {
+        return recorder.take(uid);
+    }
+};
+
+/** Sorted linked list integer set workload class.
+**/
+class WorkloadList final: public WorkloadSet {
+private:
+    /** Shared list node class.
+    **/
+    class Node final {
+    public:
+        /** Get the node size.
+         * @return Node size (in bytes)
+        **/
+        constexpr static auto size() noexcept {
+            return sizeof(Key) + sizeof(Node*);
+        }
+    public:
+        Shared<Key>   key; // Key of the node
+        Shared<Node*> next; // Next node, with a greater key
+    public:
+        /** Binding constructor.
+         * @param tx      Associated pending transaction
+         * @param address Node base address
+        **/
+        Node(Transaction& tx, void* address): key{tx, address}, next{tx, key.after()} {}
+    };
+public:
+    /** Sorted linked list workload constructor, see 'WorkloadSet'.
+    **/
+    WorkloadList(TransactionalLibrary const& library, size_t nbworkers, size_t nbtxperwrk, size_t key_range, float update_ratio, float initial_fill, Chrono::Tick duration = 0): WorkloadSet{library, alignof(Node*), sizeof(Node*), nbworkers, nbtxperwrk, key_range, update_ratio, initial_fill, duration} {}
+private:
+    /** Find the link to the first node with a key greater or equal to the given key.
+     * @param tx  Associated pending transaction
+     * @param key Key to look for
+     * @return Address of the link (in the shared region), and the node it points to (if any)
+    **/
+    ::std::pair<void*, Node*> find(Transaction& tx, Key key) const {
+        void* link = tm.get_start(); // The head of the list is the first word of the shared memory region.
+        while (true) {
+            Node* curr = Shared<Node*>{tx, link};
+            if (!curr || Node{tx, curr}.key >= key)
+                return {link, curr};
+            link = Node{tx, curr}.next.get();
+        }
+    }
+protected:
+    virtual bool contains(Key key) const {
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
+            auto curr = find(tx, key).second;
+            return curr && Node{tx, curr}.key == key;
+        });
+    }
+    virtual bool insert(Key key) const {
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            auto [link, curr] = find(tx, key);
+            if (curr && Node{tx, curr}.key == key)
+                return false;
+            Node node{tx, Shared<Node*>{tx, link}.alloc(Node::size())}; // Linked in place of 'curr'
+            node.key = key;
+            node.next = curr;
+            return true;
+        });
+    }
+    virtual bool remove(Key key) const {
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            auto [link, curr] = find(tx, key);
+            if (!curr || Node{tx, curr}.key != key)
+                return false;
+            Shared<Node*>{tx, link} = Node{tx, curr}.next.read();
+            tx.free(curr);
+            return true;
+        });
+    }
+    virtual char const* verify(size_t& count) const {
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) -> char const* {
+            count = 0;
+            Node* curr = Shared<Node*>{tx, tm.get_start()};
+            for (Key last = 0; curr; curr = Node{tx, curr}.next, ++count) {
+                Key key = Node{tx, curr}.key;
+                if (unlikely(key >= key_range || (count > 0 && key <= last)))
+                    return "Violated consistency (the list is not sorted)";
+                last = key;
+            }
+            return nullptr;
+        });
+    }
+};
+
+/** Skip list integer set workload class.
+**/
+class WorkloadSkipList final: public WorkloadSet {
+private:
+    constexpr static size_t max_level = 16; // Maximal number of levels of a node
+    /** Shared skip list node class, the head being a node of 'max_level' levels at the start of the region.
+    **/
+    class Node final {
+    public:
+        /** Get the node size for a given number of levels.
+         * @param level Number of levels of the node
+         * @return Node size (in bytes)
+        **/
+        constexpr static auto size(size_t level) noexcept {
+            return sizeof(Key) + sizeof(size_t) + level * sizeof(Node*);
+        }
+    public:
+        Shared<Key>     key; // Key of the node (unused for the head)
+        Shared<size_t> level; // Number of levels of the node (unused for the head)
+        Shared<Node*[]> next; // Next node at each level, with a greater key
+    public:
+        /** Binding constructor.
+         * @param tx      Associated pending transaction
+         * @param address Node base address
+        **/
+        Node(Transaction& tx, void* address): key{tx, address}, level{tx, key.after()}, next{tx, level.after()} {}
+    };
+    /** Get the number of levels of the node of a key, geometrically distributed and fixed per key.
+     * @param key Key of the node
+     * @return Number of levels (between 1 and 'max_level')
+    **/
+    static size_t level_of(Key key) noexcept {
+        auto hash = static_cast<uint64_t>(key) * 0x9e3779b97f4a7c15ull;
+        hash ^= hash >> 29;
+        hash *= 0xbf58476d1ce4e5b9ull;
+        hash ^= hash >> 32;
+        return ::std::min(static_cast<size_t>(__builtin_ctzll(hash | (1ull << (max_level - 1)))) + 1, max_level);
+    }
+public:
+    /** Skip list workload constructor, see 'WorkloadSet'.
+    **/
+    WorkloadSkipList(TransactionalLibrary const& library, size_t nbworkers, size_t nbtxperwrk, size_t key_range, float update_ratio, float initial_fill, Chrono::Tick duration = 0): WorkloadSet{library, alignof(Node*), Node::size(max_level), nbworkers, nbtxperwrk, key_range, update_ratio, initial_fill, duration} {}
+private:
+    /** Find the predecessors of a key at every level.
+     * @param tx    Associated pending transaction
+     * @param key   Key to look for
+     * @param preds Set to the last node with a smaller key at each level (possibly the head)
+     * @return First node with a key greater or equal to the given key, if any
+    **/
+    Node* find(Transaction& tx, Key key, void* (&preds)[max_level]) const {
+        void* pred = tm.get_start();
+        Node* curr = nullptr;
+        for (auto level = max_level; level-- > 0;) {
+            while (true) {
+                curr = Node{tx, pred}.next[level];
+                if (!curr || Node{tx, curr}.key >= key)
+                    break;
+                pred = curr;
+            }
+            preds[level] = pred;
+        }
+        return curr;
+    }
+protected:
+    virtual bool contains(Key key) const {
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
+            void* preds[max_level];
+            auto curr = find(tx, key, preds);
+            return curr && Node{tx, curr}.key == key;
+        });
+    }
+    virtual bool insert(Key key) const {
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            void* preds[max_level];
+            auto curr = find(tx, key, preds);
+            if (curr && Node{tx, curr}.key == key)
+                return false;
+            auto level = level_of(key);
+            auto address = reinterpret_cast<Node*>(tx.alloc(Node::size(level)));
+            Node node{tx, address};
+            node.key = key;
+            node.level = level;
+            for (size_t i = 0; i < level; ++i) { // Link the node after its predecessor at each of its levels
+                auto link = Node{tx, preds[i]}.next[i];
+                node.next[i] = link.read();
+                link = address;
+            }
+            return true;
+        });
+    }
+    virtual bool remove(Key key) const {
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            void* preds[max_level];
+            auto curr = find(tx, key, preds);
+            if (!curr || Node{tx, curr}.key != key)
+                return false;
+            Node node{tx, curr};
+            size_t level = node.level;
+            for (size_t i = 0; i < level; ++i)
+                Node{tx, preds[i]}.next[i] = node.next[i].read();
+            tx.free(curr);
+            return true;
+        });
+    }
+    virtual char const* verify(size_t& count) const {
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) -> char const* {
+            size_t expected[max_level] = {}; // Number of nodes with more than a given number of levels
+            count = 0;
+            Node* curr = Node{tx, tm.get_start()}.next[0];
+            for (Key last = 0; curr; curr = Node{tx, curr}.next[0], ++count) {
+                Node node{tx, curr};
+                Key key = node.key;
+                size_t level = node.level;
+                if (unlikely(key >= key_range || (count > 0 && key <= last)))
+                    return "Violated consistency (the bottom level is not sorted)";
+                if (unlikely(level != level_of(key)))
+                    return "Violated consistency (a node has the wrong number of levels)";
+                for (size_t i = 0; i < level; ++i)
+                    ++expected[i];
+                last = key;
+            }
+            for (size_t i = 1; i < max_level; ++i) { // Every upper level links, in order, the nodes that have that level
+                size_t found = 0;
+                Node* curr = Node{tx, tm.get_start()}.next[i];
+                for (Key last = 0; curr; curr = Node{tx, curr}.next[i], ++found) {
+                    Node node{tx, curr};
+                    Key key = node.key;
+                    if (unlikely((found > 0 && key <= last) || node.level.read() <= i))
+                        return "Violated consistency (an upper level is not sorted or links a node without that level)";
+                    last = key;
+                }
+                if (unlikely(found != expected[i]))
+                    return "Violated consistency (an upper level misses some nodes)";
+            }
+            return nullptr;
+        });
+    }
+};
+
+/** Chained hash set integer set workload class.
+**/
+class WorkloadHashSet final: public WorkloadSet {
+private:
+    constexpr static size_t keys_per_bucket = 4; // Expected number of keys per bucket, for a half-full key range
+    /** Shared chain node class.
+    **/
+    class Node final {
+    public:
+        /** Get the node size.
+         * @return Node size (in bytes)
+        **/
+        constexpr static auto size() noexcept {
+            return sizeof(Key) + sizeof(Node*);
+        }
+    public:
+        Shared<Key>   key; // Key of the node
+        Shared<Node*> next; // Next node of the chain
+    public:
+        /** Binding constructor.
+         * @param tx      Associated pending transaction
+         * @param address Node base address
+        **/
+        Node(Transaction& tx, void* address): key{tx, address}, next{tx, key.after()} {}
+    };
+    size_t nbbuckets; // Number of buckets, at the start of the shared memory region
+    /** Get the number of buckets for a given key range.
+     * @param key_range Key range
+     * @return Number of buckets
+    **/
+    constexpr static size_t buckets_for(size_t key_range) noexcept {
+        return ::std::max(key_range / (2 * keys_per_bucket), size_t{1});
+    }
+    /** Get the address of the bucket of a key.
+     * @param key Key
+     * @return Address of the bucket's head (in the shared region)
+    **/
+    void* bucket_of(Key key) const noexcept {
+        auto hash = static_cast<uint64_t>(key) * 0x9e3779b97f4a7c15ull;
+        return reinterpret_cast<Node**>(tm.get_start()) + (hash >> 32) % nbbuckets;
+    }
+public:
+    /** Chained hash set workload constructor, see 'WorkloadSet'.
+    **/
+    WorkloadHashSet(TransactionalLibrary const& library, size_t nbworkers, size_t nbtxperwrk, size_t key_range, float update_ratio, float initial_fill, Chrono::Tick duration = 0): WorkloadSet{library, alignof(Node*), buckets_for(key_range) * sizeof(Node*), nbworkers, nbtxperwrk, key_range, update_ratio, initial_fill, duration}, nbbuckets{buckets_for(key_range)} {}
+private:
+    /** Find the link to the node of a key in its bucket.
+     * @param tx  Associated pending transaction
+     * @param key Key to look for
+     * @return Address of the link (in the shared region), and the node of the key (if any)
+    **/
+    ::std::pair<void*, Node*> find(Transaction& tx, Key key) const {
+        void* link = bucket_of(key);
+        while (true) {
+            Node* curr = Shared<Node*>{tx, link};
+            if (!curr || Node{tx, curr}.key == key)
+                return {link, curr};
+            link = Node{tx, curr}.next.get();
+        }
+    }
+protected:
+    virtual bool contains(Key key) const {
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
+            return find(tx, key).second != nullptr;
+        });
+    }
+    virtual bool insert(Key key) const {
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            auto [link, curr] = find(tx, key);
+            if (curr)
+                return false;
+            Node node{tx, Shared<Node*>{tx, link}.alloc(Node::size())}; // Appended to the chain
+            node.key = key;
+            node.next = nullptr;
+            return true;
+        });
+    }
+    virtual bool remove(Key key) const {
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            auto [link, curr] = find(tx, key);
+            if (!curr)
+                return false;
+            Shared<Node*>{tx, link} = Node{tx, curr}.next.read();
+            tx.free(curr);
+            return true;
+        });
+    }
+    virtual char const* verify(size_t& count) const {
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) -> char const* {
+            ::std::vector<bool> seen(key_range);
+            count = 0;
+            for (size_t i = 0; i < nbbuckets; ++i) {
+                void* bucket = reinterpret_cast<Node**>(tm.get_start()) + i;
+                for (Node* curr = Shared<Node*>{tx, bucket}; curr; curr = Node{tx, curr}.next, ++count) {
+                    Key key = Node{tx, curr}.key;
+                    if (unlikely(key >= key_range || bucket_of(key) != bucket))
+                        return "Violated consistency (a key is in the wrong bucket)";
+                    if (unlikely(seen[key]))
+                        return "Violated consistency (a key is in the set twice)";
+                    seen[key] = true;
+                }
+            }
+            return nullptr;
+        });
+    }
+};
+
+/** Red-black tree integer set workload class.
+**/
+class WorkloadRBTree final: public WorkloadSet {
+private:
+    /** Node color enum class.
+    **/
+    enum class Color: uintptr_t {
+        red,
+        black
+    };
+    /** Shared tree node class.
+    **/
+    class Node final {
+    public:
+        /** Get the node size.
+         * @return Node size (in bytes)
+        **/
+        constexpr static auto size() noexcept {
+            return sizeof(Key) + sizeof(Color) + 3 * sizeof(Node*);
+        }
+    public:
+        Shared<Key>    key; // Key of the node
+        Shared<Color> color; // Color of the node
+        Shared<Node*>  left; // Left child, with smaller keys
+        Shared<Node*> right; // Right child, with greater keys
+        Shared<Node*> parent; // Parent node, 'nullptr' for the root
+    public:
+        /** Binding constructor.
+         * @param tx      Associated pending transaction
+         * @param address Node base address
+        **/
+        Node(Transaction& tx, void* address): key{tx, address}, color{tx, key.after()}, left{tx, color.after()}, right{tx, left.after()}, parent{tx, right.after()} {}
+    };
+    /** Red-black tree view of a transaction, with null-tolerant node accessors (null nodes are black leaves).
+    **/
+    class Tree final {
+    private:
+        Transaction& tx; // Associated pending transaction
+        Shared<Node*> root; // Root of the tree, at the start of the shared memory region
+    public:
+        /** Binding constructor.
+         * @param tx    Associated pending transaction
+         * @param start Start of the shared memory region
+        **/
+        Tree(Transaction& tx, void* start): tx{tx}, root{tx, start} {}
+    private:
+        Color color_of(Node* node) const {
+            return node ? Node{tx, node}.color.read() : Color::black;
+        }
+        void set_color(Node* node, Color color) const {
+            if (node)
+                Node{tx, node}.color = color;
+        }
+        Node* parent_of(Node* node) const {
+            return node ? Node{tx, node}.parent.read() : nullptr;
+        }
+        Node* left_of(Node* node) const {
+            return node ? Node{tx, node}.left.read() : nullptr;
+        }
+        Node* right_of(Node* node) const {
+            return node ? Node{tx, node}.right.read() : nullptr;
+        }
+        /** Replace a child of the parent of a node (or the root) by another node.
+         * @param node   Node to replace
+         * @param parent Parent of the node to replace
+         * @param by     Replacing node
+        **/
+        void replace(Node* node, Node* parent, Node* by) const {
+            if (!parent) {
+                root = by;
+            } else if (left_of(parent) == node) {
+                Node{tx, parent}.left = by;
+            } else {
+                Node{tx, parent}.right = by;
+            }
+        }
+        void rotate_left(Node* node) const {
+            Node bound{tx, node};
+            Node* right = bound.right;
+            Node bound_right{tx, right};
+            Node* middle = bound_right.left;
+            bound.right = middle;
+            if (middle)
+                Node{tx, middle}.parent = node;
+            Node* parent = bound.parent;
+            bound_right.parent = parent;
+            replace(node, parent, right);
+            bound_right.left = node;
+            bound.parent = right;
+        }
+        void rotate_right(Node* node) const {
+            Node bound{tx, node};
+            Node* left = bound.left;
+            Node bound_left{tx, left};
+            Node* middle = bound_left.right;
+            bound.left = middle;
+            if (middle)
+                Node{tx, middle}.parent = node;
+            Node* parent = bound.parent;
+            bound_left.parent = parent;
+            replace(node, parent, left);
+            bound_left.right = node;
+            bound.parent = left;
+        }
+        /** Restore the red-black invariants after inserting a (red) node.
+         * @param node Inserted node
+        **/
+        void fix_insert(Node* node) const {
+            while (node && node != root.read() && color_of(parent_of(node)) == Color::red) {
+                auto parent = parent_of(node);
+                auto grand = parent_of(parent);
+                if (parent == left_of(grand)) {
+                    auto uncle = right_of(grand);
+                    if (color_of(uncle) == Color::red) {
+                        set_color(parent, Color::black);
+                        set_color(uncle, Color::black);
+                        set_color(grand, Color::red);
+                        node = grand;
+                    } else {
+                        if (node == right_of(parent)) {
+                            node = parent;
+                            rotate_left(node);
+                        }
+                        set_color(parent_of(node), Color::black);
+                        set_color(parent_of(parent_of(node)), Color::red);
+                        rotate_right(parent_of(parent_of(node)));
+                    }
+                } else {
+                    auto uncle = left_of(grand);
+                    if (color_of(uncle) == Color::red) {
+                        set_color(parent, Color::black);
+                        set_color(uncle, Color::black);
+                        set_color(grand, Color::red);
+                        node = grand;
+                    } else {
+                        if (node == left_of(parent)) {
+                            node = parent;
+                            rotate_right(node);
+                        }
+                        set_color(parent_of(node), Color::black);
+                        set_color(parent_of(parent_of(node)), Color::red);
+                        rotate_left(parent_of(parent_of(node)));
+                    }
+                }
+            }
+            set_color(root, Color::black);
+        }
+        /** Restore the red-black invariants before unlinking a black node, or after replacing it.
+         * @param node Node in place of the black node
+        **/
+        void fix_remove(Node* node) const {
+            while (node != root.read() && color_of(node) == Color::black) {
+                if (node == left_of(parent_of(node))) {
+                    auto sibling = right_of(parent_of(node));
+                    if (color_of(sibling) == Color::red) {
+                        set_color(sibling, Color::black);
+                        set_color(parent_of(node), Color::red);
+                        rotate_left(parent_of(node));
+                        sibling = right_of(parent_of(node));
+                    }
+                    if (color_of(left_of(sibling)) == Color::black && color_of(right_of(sibling)) == Color::black) {
+                        set_color(sibling, Color::red);
+                        node = parent_of(node);
+                    } else {
+                        if (color_of(right_of(sibling)) == Color::black) {
+                            set_color(left_of(sibling), Color::black);
+                            set_color(sibling, Color::red);
+                            rotate_right(sibling);
+                            sibling = right_of(parent_of(node));
+                        }
+                        set_color(sibling, color_of(parent_of(node)));
+                        set_color(parent_of(node), Color::black);
+                        set_color(right_of(sibling), Color::black);
+                        rotate_left(parent_of(node));
+                        node = root;
+                    }
+                } else {
+                    auto sibling = left_of(parent_of(node));
+                    if (color_of(sibling) == Color::red) {
+                        set_color(sibling, Color::black);
+                        set_color(parent_of(node), Color::red);
+                        rotate_right(parent_of(node));
+                        sibling = left_of(parent_of(node));
+                    }
+                    if (color_of(right_of(sibling)) == Color::black && color_of(left_of(sibling)) == Color::black) {
+                        set_color(sibling, Color::red);
+                        node = parent_of(node);
+                    } else {
+                        if (color_of(left_of(sibling)) == Color::black) {
+                            set_color(right_of(sibling), Color::black);
+                            set_color(sibling, Color::red);
+                            rotate_left(sibling);
+                            sibling = left_of(parent_of(node));
+                        }
+                        set_color(sibling, color_of(parent_of(node)));
+                        set_color(parent_of(node), Color::black);
+                        set_color(left_of(sibling), Color::black);
+                        rotate_right(parent_of(node));
+                        node = root;
+                    }
+                }
+            }
+            set_color(node, Color::black);
+        }
+    public:
+        /** Find the node of a key, or the node under which it would be inserted.
+         * @param key Key to look for
+         * @return Node of the key or its would-be parent ('nullptr' for an empty tree), and whether it is the node of the key
+        **/
+        ::std::pair<Node*, bool> find(Key key) const {
+            Node* parent = nullptr;
+            Node* curr = root;
+            while (curr) {
+                Key curr_key = Node{tx, curr}.key;
+                if (key == curr_key)
+                    return {curr, true};
+                parent = curr;
+                curr = key < curr_key ? left_of(curr) : right_of(curr);
+            }
+            return {parent, false};
+        }
+        /** Insert a key, known not to be in the tree.
+         * @param key    Key to insert
+         * @param parent Node under which to insert it, as returned by 'find'
+        **/
+        void insert(Key key, Node* parent) const {
+            auto address = reinterpret_cast<Node*>(tx.alloc(Node::size()));
+            Node node{tx, address};
+            node.key = key;
+            node.color = Color::red;
+            node.left = nullptr;
+            node.right = nullptr;
+            node.parent = parent;
+            if (!parent) {
+                root = address;
+            } else if (key < Node{tx, parent}.key) {
+                Node{tx, parent}.left = address;
+            } else {
+                Node{tx, parent}.right = address;
+            }
+            fix_insert(address);
+        }
+        /** Remove a node from the tree.
+         * @param node Node to remove
+        **/
+        void remove(Node* node) const {
+            if (left_of(node) && right_of(node)) { // Move the successor's key here, and remove the successor instead
+                auto succ = right_of(node);
+                while (left_of(succ))
+                    succ = left_of(succ);
+                Node{tx, node}.key = Node{tx, succ}.key.read();
+                node = succ;
+            }
+            auto child = left_of(node) ? left_of(node) : right_of(node);
+            auto parent = parent_of(node);
+            if (child) {
+                Node{tx, child}.parent = parent;
+                replace(node, parent, child);
+                if (color_of(node) == Color::black)
+                    fix_remove(child);
+            } else if (!parent) {
+                root = nullptr;
+            } else {
+                if (color_of(node) == Color::black) // The node stands for the missing black leaf while fixing
+                    fix_remove(node);
+                parent = parent_of(node); // Possibly rotated
+                replace(node, parent, nullptr);
+            }
+            tx.free(node);
+        }
+        /** Check the invariants of a subtree.
+         * @param node   Root of the subtree
+         * @param parent Expected parent of the root
+         * @param lo     Exclusive lower bound of the keys (if 'has_lo')
+         * @param hi     Exclusive upper bound of the keys
+         * @param count  Incremented by the number of nodes
+         * @return Black height of the subtree, 0 on violated invariant
+        **/
+        size_t verify(Node* node, Node* parent, Key lo, bool has_lo, Key hi, size_t& count) const {
+            if (!node)
+                return 1;
+            Node bound{tx, node};
+            Key key = bound.key;
+            Color color = bound.color;
+            if ((has_lo && key <= lo) || key >= hi || bound.parent.read() != parent)
+                return 0;
+            if (color == Color::red && (color_of(bound.left) == Color::red || color_of(bound.right) == Color::red))
+                return 0;
+            ++count;
+            auto left = verify(bound.left, node, lo, has_lo, key, count);
+            auto right = verify(bound.right, node, key, true, hi, count);
+            if (left == 0 || left != right)
+                return 0;
+            return left + (color == Color::black ? 1 : 0);
+        }
+        /** Get the root of the tree.
+         * @return Root of the tree
+        **/
+        Node* get_root() const {
+            return root;
+        }
+    };
+public:
+    /** Red-black tree workload constructor, see 'WorkloadSet'.
+    **/
+    WorkloadRBTree(TransactionalLibrary const& library, size_t nbworkers, size_t nbtxperwrk, size_t key_range, float update_ratio, float initial_fill, Chrono::Tick duration = 0): WorkloadSet{library, alignof(Node*), sizeof(Node*), nbworkers, nbtxperwrk, key_range, update_ratio, initial_fill, duration} {}
+protected:
+    virtual bool contains(Key key) const {
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
+            return Tree{tx, tm.get_start()}.find(key).second;
+        });
+    }
+    virtual bool insert(Key key) const {
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            Tree tree{tx, tm.get_start()};
+            auto [node, found] = tree.find(key);
+            if (found)
+                return false;
+            tree.insert(key, node);
+            return true;
+        });
+    }
+    virtual bool remove(Key key) const {
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            Tree tree{tx, tm.get_start()};
+            auto [node, found] = tree.find(key);
+            if (!found)
+                return false;
+            tree.remove(node);
+            return true;
+        });
+    }
+    virtual char const* verify(size_t& count) const {
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) -> char const* {
+            Tree tree{tx, tm.get_start()};
+            count = 0;
+            auto root = tree.get_root();
+            if (unlikely(root && (Node{tx, root}.color.read() != Color::black)))
+                return "Violated consistency (the root of the tree is red)";
+            if (unlikely(tree.verify(root, nullptr, 0, false, key_range, count) == 0))
+                return "Violated consistency (the tree is unordered, unbalanced or has two red nodes in a row)";
+            return nullptr;
+        });
+    }
+};
+
+// -------------------------------------------------------------------------- //
+
+/** Zipfian distribution over [0, n), item 0 being the most frequent (Gray et al.'s generator, as in YCSB).
+**/
+class ZipfianDistribution final {
+private:
+    size_t n;     // Number of items
+    double theta; // Skew, in [0, 1)
+    double zetan; // Zeta(n, theta)
+    double alpha; // 1 / (1 - theta)
+    double eta;   // Generator constant
+    ::std::uniform_real_distribution<double> uniform; // Underlying uniform distribution
+    /** Compute the (generalized) zeta function.
+     * @param n     Number of terms
+     * @param theta Skew
+     * @return Zeta(n, theta)
+    **/
+    static double zeta(size_t n, double theta) noexcept {
+        double res = 0.;
+        for (size_t i = 1; i <= n; ++i)
+            res += 1. / ::std::pow(static_cast<double>(i), theta);
+        return res;
+    }
+public:
+    /** Parameters constructor.
+     * @param n     Non-null number of items
+     * @param theta Skew, in [0, 1) (0 for uniform)
+    **/
+    ZipfianDistribution(size_t n, double theta): n{n}, theta{theta}, zetan{zeta(n, theta)}, alpha{1. / (1. - theta)}, eta{(1. - ::std::pow(2. / static_cast<double>(n), 1. - theta)) / (1. - zeta(2, theta) / zetan)}, uniform{0., 1.} {}
+public:
+    /** Draw an item.
+     * @param engine Randomness source
+     * @return Item, in [0, n)
+    **/
+    template<class Engine> size_t operator()(Engine& engine) {
+        auto u = uniform(engine);
+        auto uz = u * zetan;
+        if (uz < 1.)
+            return 0;
+        if (uz < 1. + ::std::pow(0.5, theta))
+            return ::std::min<size_t>(1, n - 1);
+        return ::std::min(static_cast<size_t>(static_cast<double>(n) * ::std::pow(eta * u - eta + 1., alpha)), n - 1);
+    }
+};
+
+/** YCSB-style key-value workload class, on a table of fixed-size records with per-record checksums.
+**/
+class WorkloadKV final: public Workload {
+public:
+    /** Record field class alias.
+    **/
+    using Field = uint64_t;
+    /** Operation mix, as YCSB's core workloads A to F.
+    **/
+    struct Mix final {
+        float read;   // Probability of reading a record
+        float update; // Probability of updating one field of a record
+        float rmw;    // Probability of reading a record then updating one of its fields
+        float scan;   // Probability of reading a short range of records
+        float insert; // Probability of inserting a new record
+        bool latest;  // Whether the most recently inserted records are the most frequent, instead of scrambled ones
+    };
+    /** Get the operation mix of a YCSB core workload.
+     * @param name Workload letter, from 'A' to 'F'
+     * @return Operation mix, throws 'Exception::Parameter' on unknown letter
+    **/
+    static Mix mix_of(char name) {
+        switch (name) {
+        case 'A': return Mix{0.50f, 0.50f, 0.f, 0.f, 0.f, false}; // Update heavy
+        case 'B': return Mix{0.95f, 0.05f, 0.f, 0.f, 0.f, false}; // Read mostly
+        case 'C': return Mix{1.f, 0.f, 0.f, 0.f, 0.f, false};     // Read only
+        case 'D': return Mix{0.95f, 0.f, 0.f, 0.f, 0.05f, true};  // Read latest
+        case 'E': return Mix{0.f, 0.f, 0.f, 0.95f, 0.05f, false}; // Short ranges
+        case 'F': return Mix{0.50f, 0.f, 0.50f, 0.f, 0.f, false}; // Read-modify-write
+        default: throw Exception::Parameter{"unknown YCSB workload, expected a letter from A to F"};
+        }
+    }
+private:
+    constexpr static size_t max_scan_length = 100; // Scans read between 1 and that many records
+    /** Shared memory region header class, followed by the initial records then by the pointers to the inserted ones.
+    **/
+    class Header final {
+    public:
+        Shared<size_t> count; // Number of records
+    public:
+        /** Binding constructor.
+         * @param tx      Associated pending transaction
+         * @param address Region base address
+        **/
+        Header(Transaction& tx, void* address): count{tx, address} {}
+    };
+    size_t nbworkers;   // Number of concurrent workers
+    size_t nbtxperwrk;  // Number of transactions per worker
+    size_t nbrecords;   // Initial number of records
+    size_t maxrecords;  // Maximal number of records, inserts turn into updates once reached
+    size_t nbfields;    // Number of fields per record
+    Mix    mix;         // Operation mix
+    double theta;       // Zipfian skew
+    Chrono::Tick duration; // Duration of a run (in ns), 0 to run 'nbtxperwrk' transactions per worker instead
+    ::std::once_flag mutable filled; // The initial records are filled by only one of the workers
+    ::std::atomic<size_t> mutable published; // Number of records known to be committed, loosely updated
+    ::std::atomic<size_t> mutable committed; // Transactions committed by the runs since the last 'take_committed'
+    TransactionRecorder mutable recorder; // Per-worker statistics of each operation
+private:
+    /** Get the size of a record (checksum included).
+     * @return Record size (in fields)
+    **/
+    size_t record_size() const noexcept {
+        return nbfields + 1;
+    }
+    /** Get the shared memory region size.
+     * @param nbrecords  Initial number of records
+     * @param maxrecords Maximal number of records
+     * @param nbfields   Number of fields per record
+     * @return Region size (in bytes)
+    **/
+    constexpr static size_t region_size(size_t nbrecords, size_t maxrecords, size_t nbfields) noexcept {
+        return sizeof(size_t) + nbrecords * (nbfields + 1) * sizeof(Field) + (maxrecords - nbrecords) * sizeof(Field*);
+    }
+    /** Get the address of an initial record.
+     * @param key Key of the record, lower than 'nbrecords'
+     * @return Address of its checksum, followed by its fields
+    **/
+    Field* inline_record(size_t key) const noexcept {
+        return reinterpret_cast<Field*>(reinterpret_cast<size_t*>(tm.get_start()) + 1) + key * record_size();
+    }
+    /** Get the address of the pointer to an inserted record.
+     * @param key Key of the record, greater or equal to 'nbrecords'
+     * @return Address of the pointer (in the shared region)
+    **/
+    Field** inserted_record(size_t key) const noexcept {
+        return reinterpret_cast<Field**>(inline_record(nbrecords)) + (key - nbrecords);
+    }
+    /** Get the address of a record.
+     * @param tx  Associated pending transaction
+     * @param key Key of the record, lower than the number of records
+     * @return Address of its checksum, followed by its fields
+    **/
+    Field* record(Transaction& tx, size_t key) const {
+        if (key < nbrecords)
+            return inline_record(key);
+        Field* res = Shared<Field*>{tx, inserted_record(key)};
+        if (unlikely(!res))
+            throw Exception::Unreachable{"inserted record not found"};
+        return res;
+    }
+    /** Compute the checksum of a record.
+     * @param fields Fields of the record
+     * @return Checksum of the fields
+    **/
+    Field checksum(Field const* fields) const noexcept {
+        Field res = 0;
+        for (size_t i = 0; i < nbfields; ++i)
+            res += rotate(fields[i], i);
+        return res;
+    }
+    /** Rotate a field value by its position, for the checksum to depend on the order of the fields.
+     * @param value Field value
+     * @param index Field index
+     * @return Rotated value
+    **/
+    static Field rotate(Field value, size_t index) noexcept {
+        auto shift = index % 64;
+        return shift == 0 ? value : (value << shift) | (value >> (64 - shift));
+    }
+    /** Fill the given fields with values derived from a key and a seed.
+     * @param key    Key of the record
+     * @param seed   Seed value
+     * @param record Record to fill, checksum first
+    **/
+    void fill(size_t key, Field seed, Field* record) const noexcept {
+        for (size_t i = 0; i < nbfields; ++i)
+            record[1 + i] = (key * 0x9e3779b97f4a7c15ull) ^ (seed + i);
+        record[0] = checksum(record + 1);
+    }
+    /** Read a whole record and verify its checksum.
+     * @param tx     Associated pending transaction
+     * @param key    Key of the record
+     * @param buffer Private buffer of 'record_size()' fields receiving the record
+     * @return Whether the checksum is valid
+    **/
+    bool read_record(Transaction& tx, size_t key, Field* buffer) const {
+        Shared<Field[]>{tx, record(tx, key)}.read_range(0, record_size(), buffer);
+        return buffer[0] == checksum(buffer + 1);
+    }
+    /** Overwrite one field of a record, and update its checksum.
+     * @param tx    Associated pending transaction
+     * @param key   Key of the record
+     * @param index Index of the field
+     * @param value New value of the field
+     * @param old   Current value of the field
+     * @param sum   Current checksum of the record
+    **/
+    void write_field(Transaction& tx, size_t key, size_t index, Field value, Field old, Field sum) const {
+        Shared<Field[]> fields{tx, record(tx, key)};
+        fields[1 + index] = value;
+        fields[0] = sum - rotate(old, index) + rotate(value, index);
+    }
+public:
+    /** Key-value workload constructor.
+     * @param library    Transactional library to use
+     * @param nbworkers  Total number of concurrent threads
+     * @param nbtxperwrk Number of transactions per worker
+     * @param nbrecords  Initial number of records
+     * @param maxrecords Maximal number of records (at least 'nbrecords'), inserts turn into updates once reached
+     * @param nbfields   Number of fields per record
+     * @param mix        Operation mix
+     * @param theta      Zipfian skew, in [0, 1)
+     * @param duration   Duration of a run (in ns), 0 to run 'nbtxperwrk' transactions per worker instead
+    **/
+    WorkloadKV(TransactionalLibrary const& library, size_t nbworkers, size_t nbtxperwrk, size_t nbrecords, size_t maxrecords, size_t nbfields, Mix mix, double theta, Chrono::Tick duration = 0): Workload{library, alignof(Field), region_size(nbrecords, maxrecords, nbfields)}, nbworkers{nbworkers}, nbtxperwrk{nbtxperwrk}, nbrecords{nbrecords}, maxrecords{maxrecords}, nbfields{nbfields}, mix{mix}, theta{theta}, duration{duration}, published{nbrecords}, committed{0}, recorder{nbworkers, {"read", "update", "rmw", "scan", "insert"}} {}
+private:
+    /** Read transaction.
+     * @param key Key of the record
+     * @return Whether the checksum of the record was valid
+    **/
+    bool read_tx(size_t key) const {
+        ::std::vector<Field> buffer(record_size());
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
+            return read_record(tx, key, buffer.data());
+        });
+    }
+    /** Update transaction, overwriting one field.
+     * @param key   Key of the record
+     * @param index Index of the field
+     * @param value New value of the field
+    **/
+    void update_tx(size_t key, size_t index, Field value) const {
+        transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            Shared<Field[]> fields{tx, record(tx, key)};
+            write_field(tx, key, index, value, fields.read(1 + index), fields.read(0));
+        });
+    }
+    /** Read-modify-write transaction, reading a whole record then incrementing one field.
+     * @param key   Key of the record
+     * @param index Index of the field
+     * @return Whether the checksum of the record was valid
+    **/
+    bool rmw_tx(size_t key, size_t index) const {
+        ::std::vector<Field> buffer(record_size());
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            if (unlikely(!read_record(tx, key, buffer.data())))
+                return false;
+            write_field(tx, key, index, buffer[1 + index] + 1, buffer[1 + index], buffer[0]);
+            return true;
+        });
+    }
+    /** Scan transaction, reading consecutive records.
+     * @param key    Key of the first record
+     * @param length Number of records to read (at most)
+     * @param count  Loosely-updated number of records
+     * @return Whether the checksums of the records were valid
+    **/
+    bool scan_tx(size_t key, size_t length, size_t count) const {
+        length = ::std::min(length, count - key);
+        ::std::vector<Field> buffer(length * record_size());
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
+            auto inlined = key < nbrecords ? ::std::min(length, nbrecords - key) : 0;
+            Shared<Field[]>{tx, inline_record(key)}.read_range(0, inlined * record_size(), buffer.data()); // Initial records are contiguous
+            for (size_t i = inlined; i < length; ++i)
+                Shared<Field[]>{tx, record(tx, key + i)}.read_range(0, record_size(), buffer.data() + i * record_size());
+            for (size_t i = 0; i < length; ++i) {
+                auto record = buffer.data() + i * record_size();
+                if (unlikely(record[0] != checksum(record + 1)))
+                    return false;
+            }
+            return true;
+        });
+    }
+    /** Insert transaction, appending a new record.
+     * @param seed Seed of the field values
+     * @return Key of the inserted record, 'maxrecords' if the table is full
+    **/
+    size_t insert_tx(Field seed) const {
+        ::std::vector<Field> buffer(record_size());
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            Header header{tx, tm.get_start()};
+            size_t key = header.count;
+            if (key >= maxrecords)
+                return maxrecords;
+            fill(key, seed, buffer.data());
+            auto address = Shared<Field*>{tx, inserted_record(key)}.alloc(record_size() * sizeof(Field));
+            tx.write(buffer.data(), record_size() * sizeof(Field), address);
+            header.count = key + 1;
+            return key;
+        });
+    }
+public:
+    /**
+     * Fill the initial records once for every worker, then check one of them.
+    **/
+    virtual char const* init() const {
+        ::std::call_once(filled, [&]() {
+            constexpr size_t batch = 64; // Records per transaction
+            ::std::vector<Field> buffer(batch * record_size());
+            for (size_t first = 0; first < nbrecords; first += batch) {
+                auto count = ::std::min(batch, nbrecords - first);
+                for (size_t i = 0; i < count; ++i)
+                    fill(first + i, 0, buffer.data() + i * record_size());
+                transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+                    tx.write(buffer.data(), count * record_size() * sizeof(Field), inline_record(first));
+                });
+            }
+            transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+                Header{tx, tm.get_start()}.count = nbrecords;
+            });
+        });
+        auto correct = transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
+            ::std::vector<Field> buffer(record_size());
+            return Header{tx, tm.get_start()}.count == nbrecords && read_record(tx, nbrecords - 1, buffer.data());
+        });
+        if (unlikely(!correct))
+            return "Violated consistency (check that committed writes in shared memory get visible to the following transactions' reads)";
+        return nullptr;
+    }
+    /**
+     * Run nbtxperwrk operations of the mix until completion, or as many as possible during the run duration.
+     * @param uid  Unique ID of the worker
+     * @param seed Randomness source
+    **/
+    virtual char const* run(Uid uid, Seed seed) const {
+        ::std::minstd_rand engine{seed};
+        ::std::discrete_distribution<int> op_dist{mix.read, mix.update, mix.rmw, mix.scan, mix.insert};
+        ::std::uniform_int_distribution<size_t> field_dist{0, nbfields - 1};
+        ::std::uniform_int_distribution<size_t> length_dist{1, max_scan_length};
+        ZipfianDistribution zipf{nbrecords, theta};
+        auto next_key = [&]() {
+            auto count = published.load(::std::memory_order_acquire);
+            auto item = zipf(engine);
+            if (mix.latest)
+                return count - 1 - ::std::min(item, count - 1);
+            return static_cast<size_t>((static_cast<uint64_t>(item) * 0x9e3779b97f4a7c15ull) >> 17) % count; // Scrambled, so that hot keys are spread
+        };
+        Chrono elapsed;
+        elapsed.start();
+        size_t cntr = 0;
+        for (; duration > 0 ? elapsed.delta() < duration : cntr < nbtxperwrk; ++cntr) {
+            auto op = op_dist(engine);
+            if (op == 4) { // Insertion
+                auto key = recorder.record(uid, 4, [&]() { return insert_tx(engine()); });
+                if (key < maxrecords) {
+                    auto count = published.load(::std::memory_order_relaxed);
+                    while (count < key + 1 && !published.compare_exchange_weak(count, key + 1, ::std::memory_order_release, ::std::memory_order_relaxed)); // Every lower key committed before this one
+                    continue;
+                }
+                op = 1; // The table is full, update instead
+            }
+            auto key = next_key();
+            bool correct = true;
+            switch (op) {
+            case 0:
+                correct = recorder.record(uid, 0, [&]() { return read_tx(key); });
+                break;
+            case 1: {
+                auto index = field_dist(engine);
+                auto value = static_cast<Field>(engine());
+                recorder.record(uid, 1, [&]() { update_tx(key, index, value); });
+            } break;
+            case 2: {
+                auto index = field_dist(engine);
+                correct = recorder.record(uid, 2, [&]() { return rmw_tx(key, index); });
+            } break;
+            default: {
+                auto length = length_dist(engine);
+                auto count = published.load(::std::memory_order_acquire);
+                correct = recorder.record(uid, 3, [&]() { return scan_tx(key, length, count); });
+            } break;
+            }
+            if (unlikely(!correct))
+                return "Violated isolation or atomicity (a record checksum does not match its fields)";
+        }
+        committed.fetch_add(cntr, ::std::memory_order_relaxed);
+        return nullptr;
+    }
+    /**
+     * Check the checksum of every record, and that every insertion is accounted for.
+     * @param uid Unique ID of the worker (only the first one checks)
+    **/
+    virtual char const* check(Uid uid, Seed seed [[gnu::unused]]) const {
+        if (uid != 0)
+            return nullptr;
+        ::std::vector<Field> buffer(record_size());
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) -> char const* {
+            size_t count = Header{tx, tm.get_start()}.count;
+            if (unlikely(count < nbrecords || count > maxrecords || count != published.load(::std::memory_order_relaxed)))
+                return "Violated isolation or atomicity (the number of records does not match the insertions)";
+            for (size_t key = 0; key < count; ++key) {
+                if (unlikely(!read_record(tx, key, buffer.data())))
+                    return "Violated isolation or atomicity (a record checksum does not match its fields)";
+            }
+            return nullptr;
+        });
+    }
+    virtual size_t take_committed() {
+        return committed.exchange(0, ::std::memory_order_relaxed);
+    }
+    virtual ::std::vector<TransactionStats> take_stats(Uid uid) {
+        return recorder.take(uid);
+    }
+};
+
+// -------------------------------------------------------------------------- //
+
+/** Travel reservation workload class, after STAMP's "vacation" (high contention settings).
+**/
+class WorkloadVacation final: public Workload {
+public:
+    /** Shared word class alias.
+    **/
+    using Word = uint64_t;
+private:
+    constexpr static size_t nbtypes      = 3;   // Types of resources: cars, flights and rooms
+    constexpr static size_t nbqueries    = 4;   // Resources queried per transaction
+    constexpr static size_t query_ratio  = 60;  // Percentage of the resources that are queried
+    constexpr static size_t user_ratio   = 90;  // Percentage of reservations, the rest being customer deletions and table updates
+    constexpr static size_t max_reserved = 16;  // Maximal number of reservations per customer
+    constexpr static Word   capacity     = 100; // Initial capacity of a resource, and capacity added or removed by a table update
+    /** Shared resource class.
+    **/
+    class Resource final {
+    public:
+        constexpr static size_t words = 3; // Size (in words)
+        Shared<Word> total; // Total capacity
+        Shared<Word> free;  // Capacity not reserved yet
+        Shared<Word> price; // Price of one reservation
+    public:
+        /** Binding constructor.
+         * @param tx      Associated pending transaction
+         * @param address Resource base address
+        **/
+        Resource(Transaction& tx, void* address): total{tx, address}, free{tx, total.after()}, price{tx, free.after()} {}
+    };
+    /** Shared customer class, each reservation being the resource index then the price paid.
+    **/
+    class Customer final {
+    public:
+        constexpr static size_t words = 1 + 2 * max_reserved; // Size (in words)
+        Shared<Word>        count; // Number of reservations
+        Shared<Word[]> reservations; // Reservations
+    public:
+        /** Binding constructor.
+         * @param tx      Associated pending transaction
+         * @param address Customer base address
+        **/
+        Customer(Transaction& tx, void* address): count{tx, address}, reservations{tx, count.after()} {}
+    };
+    size_t nbworkers;    // Number of concurrent workers
+    size_t nbtxperwrk;   // Number of transactions per worker
+    size_t nbrelations;  // Number of resources of each type, and of customers
+    Chrono::Tick duration; // Duration of a run (in ns), 0 to run 'nbtxperwrk' transactions per worker instead
+    ::std::once_flag mutable filled; // The tables are filled by only one of the workers
+    ::std::atomic<size_t> mutable committed; // Transactions committed by the runs since the last 'take_committed'
+    TransactionRecorder mutable recorder; // Per-worker statistics of each client action
+private:
+    /** Get the address of a resource.
+     * @param index Resource index, its type times 'nbrelations' plus its identifier
+     * @return Resource base address
+    **/
+    void* resource(size_t index) const noexcept {
+        return reinterpret_cast<Word*>(tm.get_start()) + index * Resource::words;
+    }
+    /** Get the address of a customer.
+     * @param id Customer identifier
+     * @return Customer base address
+    **/
+    void* customer(size_t id) const noexcept {
+        return reinterpret_cast<Word*>(tm.get_start()) + nbtypes * nbrelations * Resource::words + id * Customer::words;
+    }
+public:
+    /** Vacation workload constructor.
+     * @param library     Transactional library to use
+     * @param nbworkers   Total number of concurrent threads
+     * @param nbtxperwrk  Number of transactions per worker
+     * @param nbrelations Number of resources of each type, and of customers
+     * @param duration    Duration of a run (in ns), 0 to run 'nbtxperwrk' transactions per worker instead
+    **/
+    WorkloadVacation(TransactionalLibrary const& library, size_t nbworkers, size_t nbtxperwrk, size_t nbrelations = 4096, Chrono::Tick duration = 0): Workload{library, alignof(Word), nbrelations * (nbtypes * Resource::words + Customer::words) * sizeof(Word)}, nbworkers{nbworkers}, nbtxperwrk{nbtxperwrk}, nbrelations{nbrelations}, duration{duration}, committed{0}, recorder{nbworkers, {"reserve", "delete", "update"}} {}
+private:
+    /** Reservation transaction: query some resources, and reserve the most expensive available one of each type.
+     * @param id      Customer identifier
+     * @param queries Indices of the queried resources
+    **/
+    void reserve_tx(size_t id, size_t const (&queries)[nbqueries]) const {
+        transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            size_t best[nbtypes] = {};
+            Word best_price[nbtypes] = {};
+            for (auto index: queries) {
+                Resource res{tx, resource(index)};
+                auto type = index / nbrelations;
+                Word price = res.price;
+                if (res.free.read() > 0 && price > best_price[type]) {
+                    best[type] = index;
+                    best_price[type] = price;
+                }
+            }
+            Customer cust{tx, customer(id)};
+            Word count = cust.count;
+            for (size_t type = 0; type < nbtypes; ++type) {
+                if (best_price[type] == 0 || count >= max_reserved)
+                    continue;
+                Resource res{tx, resource(best[type])};
+                res.free = res.free.read() - 1;
+                cust.reservations[2 * count] = best[type];
+                cust.reservations[2 * count + 1] = best_price[type];
+                ++count;
+            }
+            cust.count = count;
+        });
+    }
+    /** Customer deletion transaction, cancelling all of its reservations.
+     * @param id Customer identifier
+    **/
+    void delete_tx(size_t id) const {
+        transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            Customer cust{tx, customer(id)};
+            Word count = cust.count;
+            for (size_t i = 0; i < count; ++i) {
+                Resource res{tx, resource(cust.reservations[2 * i])};
+                res.free = res.free.read() + 1;
+            }
+            cust.count = 0;
+        });
+    }
+    /** Table update transaction, adding or removing capacity to some resources.
+     * @param queries Indices of the updated resources
+     * @param adds    Whether capacity is added to each resource, instead of removed
+     * @param prices  New price of each resource capacity is added to
+    **/
+    void update_tx(size_t const (&queries)[nbqueries], bool const (&adds)[nbqueries], Word const (&prices)[nbqueries]) const {
+        transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            for (size_t i = 0; i < nbqueries; ++i) {
+                Resource res{tx, resource(queries[i])};
+                Word free = res.free;
+                if (adds[i]) {
+                    res.total = res.total.read() + capacity;
+                    res.free = free + capacity;
+                    res.price = prices[i];
+                } else if (free >= capacity) { // Only capacity that is not reserved can be removed
+                    res.total = res.total.read() - capacity;
+                    res.free = free - capacity;
+                }
+            }
+        });
+    }
+public:
+    /**
+     * Fill the resource tables once for every worker.
+    **/
+    virtual char const* init() const {
+        ::std::call_once(filled, [&]() {
+            ::std::minstd_rand engine{};
+            ::std::uniform_int_distribution<Word> price_dist{50, 1000};
+            constexpr size_t batch = 64; // Resources per transaction
+            for (size_t first = 0; first < nbtypes * nbrelations; first += batch) {
+                ::std::vector<Word> words;
+                for (size_t i = first; i < ::std::min(first + batch, nbtypes * nbrelations); ++i)
+                    words.insert(words.end(), {capacity, capacity, price_dist(engine)});
+                transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+                    tx.write(words.data(), words.size() * sizeof(Word), resource(first));
+                });
+            }
+        });
+        auto correct = transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
+            return Resource{tx, resource(nbtypes * nbrelations - 1)}.total == capacity;
+        });
+        if (unlikely(!correct))
+            return "Violated consistency (check that committed writes in shared memory get visible to the following transactions' reads)";
+        return nullptr;
+    }
+    /**
+     * Run nbtxperwrk client actions until completion, or as many as possible during the run duration.
+     * @param uid  Unique ID of the worker
+     * @param seed Randomness source
+    **/
+    virtual char const* run(Uid uid, Seed seed) const {
+        ::std::minstd_rand engine{seed};
+        ::std::uniform_int_distribution<size_t> action_dist{0, 99};
+        ::std::uniform_int_distribution<size_t> type_dist{0, nbtypes - 1};
+        ::std::uniform_int_distribution<size_t> id_dist{0, ::std::max(nbrelations * query_ratio / 100, size_t{1}) - 1};
+        ::std::uniform_int_distribution<size_t> customer_dist{0, nbrelations - 1};
+        ::std::uniform_int_distribution<Word> price_dist{50, 1000};
+        ::std::bernoulli_distribution add_dist{0.5};
+        Chrono elapsed;
+        elapsed.start();
+        size_t cntr = 0;
+        for (; duration > 0 ? elapsed.delta() < duration : cntr < nbtxperwrk; ++cntr) {
+            size_t queries[nbqueries];
+            for (auto& query: queries)
+                query = type_dist(engine) * nbrelations + id_dist(engine);
+            auto action = action_dist(engine);
+            if (action < user_ratio) {
+                auto id = customer_dist(engine);
+                recorder.record(uid, 0, [&]() { reserve_tx(id, queries); });
+            } else if (action % 2 == 0) {
+                auto id = customer_dist(engine);
+                recorder.record(uid, 1, [&]() { delete_tx(id); });
+            } else {
+                bool adds[nbqueries];
+                Word prices[nbqueries];
+                for (size_t i = 0; i < nbqueries; ++i) {
+                    adds[i] = add_dist(engine);
+                    prices[i] = price_dist(engine);
+                }
+                recorder.record(uid, 2, [&]() { update_tx(queries, adds, prices); });
+            }
+        }
+        committed.fetch_add(cntr, ::std::memory_order_relaxed);
+        return nullptr;
+    }
+    /**
+     * Check that the reserved capacity of every resource matches the customers' reservations.
+     * @param uid Unique ID of the worker (only the first one checks)
+    **/
+    virtual char const* check(Uid uid, Seed seed [[gnu::unused]]) const {
+        if (uid != 0)
+            return nullptr;
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) -> char const* {
+            ::std::vector<Word> reserved(nbtypes * nbrelations);
+            for (size_t id = 0; id < nbrelations; ++id) {
+                Customer cust{tx, customer(id)};
+                Word count = cust.count;
+                if (unlikely(count > max_reserved))
+                    return "Violated consistency (a customer has too many reservations)";
+                for (size_t i = 0; i < count; ++i) {
+                    Word index = cust.reservations[2 * i];
+                    if (unlikely(index >= nbtypes * nbrelations))
+                        return "Violated consistency (a reservation refers to no resource)";
+                    ++reserved[index];
+                }
+            }
+            for (size_t index = 0; index < nbtypes * nbrelations; ++index) {
+                Resource res{tx, resource(index)};
+                Word total = res.total;
+                Word free = res.free;
+                if (unlikely(free > total || total - free != reserved[index]))
+                    return "Violated isolation or atomicity (the reserved capacity of a resource does not match the reservations)";
+            }
+            return nullptr;
+        });
+    }
+    virtual size_t take_committed() {
+        return committed.exchange(0, ::std::memory_order_relaxed);
+    }
+    virtual ::std::vector<TransactionStats> take_stats(Uid uid) {
+        return recorder.take(uid);
+    }
+};
+
+/** K-means clustering workload class, after STAMP's "kmeans" (high contention settings).
+**/
+class WorkloadKMeans final: public Workload {
+public:
+    /** Coordinate class alias, in fixed point so that sums are exact.
+    **/
+    using Coord = int64_t;
+private:
+    constexpr static size_t nbdims     = 8;     // Dimensions of a point
+    constexpr static size_t nbclusters = 15;    // Number of clusters
+    constexpr static Coord  max_coord  = 1 << 20; // Coordinates are in [0, max_coord)
+    /** Shared cluster class, the center followed by the accumulated points of the current iteration.
+    **/
+    class Cluster final {
+    public:
+        constexpr static size_t words = 2 * nbdims + 1; // Size (in coordinates)
+        Shared<Coord[nbdims]> center; // Center, computed at the end of the previous iteration
+        Shared<Coord[nbdims]> sums;   // Sum of the points nearest to the center
+        Shared<Coord>        count;   // Number of points nearest to the center
+    public:
+        /** Binding constructor.
+         * @param tx      Associated pending transaction
+         * @param address Cluster base address
+        **/
+        Cluster(Transaction& tx, void* address): center{tx, address}, sums{tx, center.after()}, count{tx, sums.after()} {}
+    };
+    size_t nbworkers;  // Number of concurrent workers
+    size_t nbtxperwrk; // Number of transactions per worker
+    Chrono::Tick duration; // Duration of a run (in ns), 0 to run 'nbtxperwrk' transactions per worker instead
+    ::std::vector<Coord> points; // Points to cluster ('nbdims' coordinates each, private and read-only)
+    Coord totals[nbdims];  // Sum of all the points
+    Barrier barrier;       // Barrier for thread synchronization between iterations
+    ::std::atomic<bool> mutable proceed; // Whether to run another iteration, decided by the first worker
+    ::std::once_flag mutable filled; // The centers are initialized by only one of the workers
+    ::std::atomic<size_t> mutable committed; // Transactions committed by the runs since the last 'take_committed'
+    TransactionRecorder mutable recorder; // Per-worker statistics of the point assignments and center updates
+private:
+    /** Get the address of a cluster.
+     * @param index Cluster index
+     * @return Cluster base address
+    **/
+    void* cluster(size_t index) const noexcept {
+        return reinterpret_cast<Coord*>(tm.get_start()) + index * Cluster::words;
+    }
+    /** Get the number of points, enough for each worker to assign 'nbtxperwrk' points in a few iterations.
+     * @param nbworkers  Number of concurrent workers
+     * @param nbtxperwrk Number of transactions per worker
+     * @return Number of points
+    **/
+    static size_t points_for(size_t nbworkers, size_t nbtxperwrk) noexcept {
+        return ::std::max(nbworkers * nbtxperwrk / 8, nbworkers);
+    }
+public:
+    /** K-means workload constructor.
+     * @param library    Transactional library to use
+     * @param nbworkers  Total number of concurrent threads
+     * @param nbtxperwrk Number of transactions per worker
+     * @param duration   Duration of a run (in ns), 0 to run 'nbtxperwrk' transactions per worker instead
+    **/
+    WorkloadKMeans(TransactionalLibrary const& library, size_t nbworkers, size_t nbtxperwrk, Chrono::Tick duration = 0): Workload{library, alignof(Coord), nbclusters * Cluster::words * sizeof(Coord)}, nbworkers{nbworkers}, nbtxperwrk{nbtxperwrk}, duration{duration}, points(points_for(nbworkers, nbtxperwrk) * nbdims), totals{}, barrier{static_cast<Barrier::Counter>(nbworkers)}, proceed{false}, committed{0}, recorder{nbworkers, {"assign", "update"}} {
+        ::std::minstd_rand engine{};
+        ::std::uniform_int_distribution<Coord> coord_dist{0, max_coord - 1};
+        ::std::normal_distribution<double> noise_dist{0., max_coord / 32.};
+        Coord blobs[nbclusters][nbdims]; // Points are drawn around these
+        for (auto& blob: blobs)
+            for (auto& coord: blob)
+                coord = coord_dist(engine);
+        for (size_t i = 0; i < points.size(); ++i) {
+            auto coord = blobs[(i / nbdims) % nbclusters][i % nbdims] + static_cast<Coord>(noise_dist(engine));
+            points[i] = ::std::clamp<Coord>(coord, 0, max_coord - 1);
+            totals[i % nbdims] += points[i];
+        }
+    }
+private:
+    /** Assignment transaction, adding a point to the cluster with the nearest center.
+     * @param point   Coordinates of the point
+     * @param centers Private copy of the centers of the current iteration
+    **/
+    void assign_tx(Coord const* point, Coord const (&centers)[nbclusters][nbdims]) const {
+        size_t best = 0;
+        auto best_dist = ::std::numeric_limits<double>::max();
+        for (size_t k = 0; k < nbclusters; ++k) {
+            double dist = 0.;
+            for (size_t d = 0; d < nbdims; ++d)
+                dist += static_cast<double>(point[d] - centers[k][d]) * static_cast<double>(point[d] - centers[k][d]);
+            if (dist < best_dist) {
+                best = k;
+                best_dist = dist;
+            }
+        }
+        transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            Cluster cluster{tx, this->cluster(best)};
+            Coord sums[nbdims];
+            cluster.sums.read_range(0, nbdims, sums);
+            for (size_t d = 0; d < nbdims; ++d)
+                cluster.sums[d] = sums[d] + point[d];
+            cluster.count = cluster.count.read() + 1;
+        });
+    }
+    /** Center update transaction, ending an iteration and checking that every point was accounted for.
+     * @param nbpoints Number of points
+     * @return Whether the sums and counts of the clusters match the assigned points
+    **/
+    bool update_tx(size_t nbpoints) const {
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            Coord totals[nbdims] = {};
+            Coord count = 0;
+            for (size_t k = 0; k < nbclusters; ++k) {
+                Cluster cluster{tx, this->cluster(k)};
+                Coord sums[nbdims];
+                cluster.sums.read_range(0, nbdims, sums);
+                Coord local = cluster.count;
+                for (size_t d = 0; d < nbdims; ++d) {
+                    totals[d] += sums[d];
+                    if (local > 0)
+                        cluster.center[d] = sums[d] / local;
+                    cluster.sums[d] = 0;
+                }
+                cluster.count = 0;
+                count += local;
+            }
+            if (static_cast<size_t>(count) != nbpoints)
+                return false;
+            for (size_t d = 0; d < nbdims; ++d) {
+                if (totals[d] != this->totals[d])
+                    return false;
+            }
+            return true;
+        });
+    }
+public:
+    /**
+     * Initialize the centers to the first points once for every worker.
+    **/
+    virtual char const* init() const {
+        ::std::call_once(filled, [&]() {
+            transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+                for (size_t k = 0; k < nbclusters; ++k) {
+                    Cluster cluster{tx, this->cluster(k)};
+                    for (size_t d = 0; d < nbdims; ++d)
+                        cluster.center[d] = points[(k * (points.size() / nbdims) / nbclusters) * nbdims + d];
+                }
+            });
+        });
+        return nullptr;
+    }
+    /**
+     * Run iterations over every point until nbtxperwrk assignments, or as many as possible during the run duration.
+     * Each worker assigns its share of the points, then the first worker updates the centers.
+     * @param uid Unique ID of the worker
+    **/
+    virtual char const* run(Uid uid, Seed seed [[gnu::unused]]) const {
+        auto const nbpoints = points.size() / nbdims;
+        auto const first = nbpoints * uid / nbworkers;
+        auto const last = nbpoints * (uid + 1) / nbworkers;
+        Chrono elapsed;
+        elapsed.start();
+        size_t cntr = 0;
+        char const* error = nullptr;
+        do {
+            Coord centers[nbclusters][nbdims];
+            transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) {
+                for (size_t k = 0; k < nbclusters; ++k)
+                    Cluster{tx, cluster(k)}.center.read_range(0, nbdims, centers[k]);
+            });
+            for (auto i = first; i < last; ++i, ++cntr)
+                recorder.record(uid, 0, [&]() { assign_tx(points.data() + i * nbdims, centers); });
+            barrier.sync();
+            if (uid == 0) {
+                if (unlikely(!recorder.record(uid, 1, [&]() { return update_tx(nbpoints); })))
+                    error = "Violated isolation or atomicity (the clusters do not account for every assigned point)";
+                ++cntr;
+                proceed.store(!error && (duration > 0 ? elapsed.delta() < duration : cntr < nbtxperwrk), ::std::memory_order_relaxed);
+            }
+            barrier.sync();
+        } while (proceed.load(::std::memory_order_relaxed));
+        committed.fetch_add(cntr, ::std::memory_order_relaxed);
+        return error;
+    }
+    /**
+     * Check that the centers lie within the points' bounding box, and that no assignment is pending.
+     * @param uid Unique ID of the worker (only the first one checks)
+    **/
+    virtual char const* check(Uid uid, Seed seed [[gnu::unused]]) const {
+        if (uid != 0)
+            return nullptr;
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) -> char const* {
+            for (size_t k = 0; k < nbclusters; ++k) {
+                Coord words[Cluster::words];
+                Shared<Coord[Cluster::words]>{tx, this->cluster(k)}.read_range(0, Cluster::words, words);
+                for (size_t d = 0; d < nbdims; ++d) {
+                    if (unlikely(words[d] < 0 || words[d] >= max_coord))
+                        return "Violated consistency (a center lies outside of the points)";
+                    if (unlikely(words[nbdims + d] != 0))
+                        return "Violated consistency (a cluster has pending assignments)";
+                }
+                if (unlikely(words[2 * nbdims] != 0))
+                    return "Violated consistency (a cluster has pending assignments)";
+            }
+            return nullptr;
+        });
+    }
+    virtual size_t take_committed() {
+        return committed.exchange(0, ::std::memory_order_relaxed);
+    }
+    virtual ::std::vector<TransactionStats> take_stats(Uid uid) {
+        return recorder.take(uid);
+    }
+};
+
+/** Gene sequencing workload class, after STAMP's "genome" (segments of one fixed length, overlapping by all but one nucleotide).
+**/
+class WorkloadGenome final: public Workload {
+public:
+    /** Segment class alias, 2 bits per nucleotide, the first one in the most significant bits.
+    **/
+    using Segment = uint64_t;
+private:
+    constexpr static size_t segment_length = sizeof(Segment) * 4; // Nucleotides per segment
+    constexpr static size_t duplicates     = 3; // Segments sampled at random positions, per position (on top of one per position)
+    /** Shared segment node class.
+    **/
+    class Node final {
+    public:
+        constexpr static size_t words = 4; // Size (in words)
+        Shared<Segment> segment; // Nucleotides of the segment
+        Shared<Node*>      next; // Next node in the same bucket
+        Shared<Node*>      succ; // Node of the following segment in the gene, 'nullptr' if not linked yet
+        Shared<uintptr_t>  pred; // Whether a node links to this one as its following segment
+    public:
+        /** Binding constructor.
+         * @param tx      Associated pending transaction
+         * @param address Node base address
+        **/
+        Node(Transaction& tx, void* address): segment{tx, address}, next{tx, segment.after()}, succ{tx, next.after()}, pred{tx, succ.after()} {}
+    };
+    size_t nbworkers;   // Number of concurrent workers
+    size_t nbbuckets;   // Number of buckets of the segment hash set, at the start of the shared memory region
+    size_t slice;       // Number of nodes reserved for each worker, after the buckets
+    ::std::vector<uint8_t> gene;     // Nucleotides of the gene to rebuild (private and read-only)
+    ::std::vector<Segment> segments; // Sampled segments, with duplicates (private and read-only)
+    ::std::vector<size_t> mutable used; // Number of nodes used by each worker in the current run
+    Barrier barrier;    // Barrier for thread synchronization between phases
+    ::std::atomic<size_t> mutable committed; // Transactions committed by the runs since the last 'take_committed'
+    TransactionRecorder mutable recorder; // Per-worker statistics of each phase
+private:
+    /** Get the length of the gene, for every worker to run about 'nbtxperwrk' transactions.
+     * @param nbworkers  Number of concurrent workers
+     * @param nbtxperwrk Number of transactions per worker
+     * @return Number of nucleotides of the gene
+    **/
+    static size_t gene_length_for(size_t nbworkers, size_t nbtxperwrk) noexcept {
+        return ::std::max(nbworkers * nbtxperwrk / (duplicates + 2), 4 * segment_length);
+    }
+    /** Get the number of buckets of the segment hash set, for a given length of gene.
+     * @param length Number of nucleotides of the gene
+     * @return Number of buckets
+    **/
+    static size_t buckets_for(size_t length) noexcept {
+        return length / 2;
+    }
+    /** Get the address of the bucket of a segment.
+     * @param segment Segment
+     * @return Address of the bucket's head (in the shared region)
+    **/
+    void* bucket_of(Segment segment) const noexcept {
+        return reinterpret_cast<Node**>(tm.get_start()) + ((segment * 0x9e3779b97f4a7c15ull) >> 32) % nbbuckets;
+    }
+    /** Get the address of a worker's node.
+     * @param uid   Unique ID of the worker
+     * @param index Index of the node in the worker's slice
+     * @return Node base address
+    **/
+    Node* node(Uid uid, size_t index) const noexcept {
+        return reinterpret_cast<Node*>(reinterpret_cast<uintptr_t*>(tm.get_start()) + nbbuckets + (uid * slice + index) * Node::words);
+    }
+    /** Find the node of a segment.
+     * @param tx      Associated pending transaction
+     * @param segment Segment to look for
+     * @return Node of the segment, 'nullptr' if none
+    **/
+    Node* find(Transaction& tx, Segment segment) const {
+        for (Node* curr = Shared<Node*>{tx, bucket_of(segment)}; curr; curr = Node{tx, curr}.next) {
+            if (Node{tx, curr}.segment == segment)
+                return curr;
+        }
+        return nullptr;
+    }
+public:
+    /** Genome workload constructor, running one sequencing per run.
+     * @param library    Transactional library to use
+     * @param nbworkers  Total number of concurrent threads
+     * @param nbtxperwrk Number of transactions per worker, which sets the length of the gene
+    **/
+    WorkloadGenome(TransactionalLibrary const& library, size_t nbworkers, size_t nbtxperwrk): Workload{library, alignof(Node*), (buckets_for(gene_length_for(nbworkers, nbtxperwrk)) + (duplicates + 1) * gene_length_for(nbworkers, nbtxperwrk) * Node::words + nbworkers * Node::words) * sizeof(Node*)}, nbworkers{nbworkers}, nbbuckets{buckets_for(gene_length_for(nbworkers, nbtxperwrk))}, used(nbworkers), barrier{static_cast<Barrier::Counter>(nbworkers)}, committed{0}, recorder{nbworkers, {"insert", "link"}} {
+        auto length = gene_length_for(nbworkers, nbtxperwrk);
+        auto positions = length - segment_length + 1;
+        ::std::minstd_rand engine{};
+        ::std::uniform_int_distribution<int> nucleotide_dist{0, 3};
+        ::std::vector<Segment> overlaps;
+        do { // Draw a gene where no overlap (all but one nucleotide of a segment) repeats, so that it has only one sequencing
+            gene.resize(length);
+            for (auto& nucleotide: gene)
+                nucleotide = static_cast<uint8_t>(nucleotide_dist(engine));
+            segments.clear();
+            overlaps.clear();
+            for (size_t pos = 0; pos < positions; ++pos) {
+                Segment segment = 0;
+                for (size_t i = 0; i < segment_length; ++i)
+                    segment = (segment << 2) | gene[pos + i];
+                segments.push_back(segment);
+                overlaps.push_back(segment >> 2);
+            }
+            overlaps.push_back(segments.back() & (~Segment{0} >> 2));
+            ::std::sort(overlaps.begin(), overlaps.end());
+        } while (::std::adjacent_find(overlaps.begin(), overlaps.end()) != overlaps.end());
+        ::std::uniform_int_distribution<size_t> position_dist{0, positions - 1};
+        for (size_t i = 0; i < duplicates * positions; ++i)
+            segments.push_back(segments[position_dist(engine)]);
+        ::std::shuffle(segments.begin(), segments.end(), engine);
+        slice = (segments.size() + nbworkers - 1) / nbworkers;
+    }
+private:
+    /** Insertion transaction, adding a segment to the hash set if not already in.
+     * @param uid     Unique ID of the worker
+     * @param segment Segment to insert
+     * @return Whether the segment was inserted, in the next node of the worker's slice
+    **/
+    bool insert_tx(Uid uid, Segment segment) const {
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            if (find(tx, segment))
+                return false;
+            Shared<Node*> bucket{tx, bucket_of(segment)};
+            auto address = node(uid, used[uid]);
+            Node node{tx, address};
+            node.segment = segment;
+            node.next = bucket.read();
+            node.succ = nullptr;
+            node.pred = 0;
+            bucket = address;
+            return true;
+        });
+    }
+    /** Link transaction, finding the segment that follows a given one in the gene.
+     * @param address Node of the segment
+     * @return Whether a following segment was found
+    **/
+    bool link_tx(Node* address) const {
+        return transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+            Node node{tx, address};
+            Segment segment = node.segment;
+            for (Segment nucleotide = 0; nucleotide < 4; ++nucleotide) {
+                auto succ = find(tx, (segment << 2) | nucleotide);
+                if (!succ || succ == address || Node{tx, succ}.pred.read() != 0)
+                    continue;
+                node.succ = succ;
+                Node{tx, succ}.pred = 1;
+                return true;
+            }
+            return false;
+        });
+    }
+public:
+    virtual char const* init() const {
+        return nullptr;
+    }
+    /**
+     * Sequence the gene: clear the hash set, insert the segments without duplicates, then link each segment to the next one.
+     * Each worker handles its share of every phase; one sequencing is run whatever the duration.
+     * @param uid Unique ID of the worker
+    **/
+    virtual char const* run(Uid uid, Seed seed [[gnu::unused]]) const {
+        size_t cntr = 0;
+        constexpr size_t batch = 64; // Buckets cleared per transaction
+        for (auto first = nbbuckets * uid / nbworkers; first < nbbuckets * (uid + 1) / nbworkers; first += batch, ++cntr) {
+            auto count = ::std::min(batch, nbbuckets * (uid + 1) / nbworkers - first);
+            transactional(tm, Transaction::Mode::read_write, [&](Transaction& tx) {
+                for (size_t i = 0; i < count; ++i)
+                    Shared<Node*>{tx, reinterpret_cast<Node**>(tm.get_start()) + first + i} = nullptr;
+            });
+        }
+        used[uid] = 0;
+        barrier.sync();
+        for (auto i = slice * uid; i < ::std::min(slice * (uid + 1), segments.size()); ++i, ++cntr) {
+            if (recorder.record(uid, 0, [&]() { return insert_tx(uid, segments[i]); }))
+                ++used[uid];
+        }
+        barrier.sync();
+        for (size_t i = 0; i < used[uid]; ++i, ++cntr)
+            recorder.record(uid, 1, [&]() { return link_tx(node(uid, i)); });
+        barrier.sync();
+        committed.fetch_add(cntr, ::std::memory_order_relaxed);
+        return nullptr;
+    }
+    /**
+     * Rebuild the gene from the first segment, following the links, and compare it with the original one.
+     * @param uid Unique ID of the worker (only the first one checks)
+    **/
+    virtual char const* check(Uid uid, Seed seed [[gnu::unused]]) const {
+        if (uid != 0)
+            return nullptr;
+        return transactional(tm, Transaction::Mode::read_only, [&](Transaction& tx) -> char const* {
+            Node* first = nullptr;
+            size_t count = 0;
+            for (Uid worker = 0; worker < nbworkers; ++worker) {
+                for (size_t i = 0; i < used[worker]; ++i, ++count) {
+                    if (Node{tx, node(worker, i)}.pred.read() != 0)
+                        continue;
+                    if (unlikely(first))
+                        return "Violated isolation or atomicity (more than one segment has no predecessor)";
+                    first = node(worker, i);
+                }
+            }
+            if (unlikely(count != gene.size() - segment_length + 1))
+                return "Violated isolation or atomicity (the segments were not inserted exactly once)";
+            if (unlikely(!first))
+                return "Violated consistency (every segment has a predecessor)";
+            ::std::vector<uint8_t> rebuilt;
+            Segment segment = Node{tx, first}.segment;
+            for (size_t i = 0; i < segment_length; ++i)
+                rebuilt.push_back(static_cast<uint8_t>((segment >> (2 * (segment_length - 1 - i))) & 3));
+            for (Node* curr = Node{tx, first}.succ; curr && rebuilt.size() <= gene.size(); curr = Node{tx, curr}.succ)
+                rebuilt.push_back(static_cast<uint8_t>(Node{tx, curr}.segment.read() & 3));
+            if (unlikely(rebuilt != gene))
+                return "Violated isolation or atomicity (the rebuilt gene differs from the original one)";
+            return nullptr;
+        });
+    }
+    virtual size_t take_committed() {
+        return committed.exchange(0, ::std::memory_order_relaxed);
+    }
+    virtual ::std::vector<TransactionStats> take_stats(Uid uid) {
+        return recorder.take(uid);
+    }
+};
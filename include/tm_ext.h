@@ -0,0 +1,98 @@
+/**
+ * @file   tm_ext.h
+ *
+ * @section DESCRIPTION
+ *
+ * Optional extension interface of the transaction manager (C and C++ versions).
+ *
+ * A library may export 'tm_ext_query', returning a table of extra entry points.
+ * Every entry point of the table is optional (NULL if not provided), and a
+ * library that does not export 'tm_ext_query' is used through 'tm.h' alone.
+ * Entry points are only ever appended: a caller reads the ones that fit in the
+ * 'size' the library reports.
+**/
+
+#pragma once
+
+#ifdef __cplusplus
+    #include "tm.hpp"
+#else
+    #include <stdbool.h>
+    #include <stddef.h>
+    #include <stdint.h>
+    #include "tm.h"
+#endif
+
+// -------------------------------------------------------------------------- //
+
+#define TM_EXT_VERSION 1 // Version of the extension table below
+
+/** One named statistic of a shared memory region.
+**/
+struct tm_ext_stat {
+    char const* name; // Statistic name, statically allocated
+    uint64_t    value; // Statistic value
+};
+
+/** Extension table, filled by the library.
+**/
+struct tm_ext {
+    uint32_t version; // 'TM_EXT_VERSION' the library was built with
+    uint32_t size;    // 'sizeof(struct tm_ext)' the library was built with
+    /** [thread-safe] Bulk read operation, same contract as 'tm_read', for long scans.
+    **/
+    bool (*read_range)(shared_t shared, tx_t tx, void const* source, size_t size, void* target);
+    /** [thread-safe] Read of exactly one word (i.e. 'tm_align' bytes), same contract as 'tm_read' otherwise.
+    **/
+    bool (*read_word)(shared_t shared, tx_t tx, void const* source, void* target);
+    /** [thread-safe] Write of exactly one word (i.e. 'tm_align' bytes), same contract as 'tm_write' otherwise.
+    **/
+    bool (*write_word)(shared_t shared, tx_t tx, void const* source, void* target);
+    /** [thread-safe] Get the statistics of a shared memory region.
+     * @param shared   Shared memory region
+     * @param stats    Statistics to fill, at most 'capacity' of them
+     * @param capacity Number of statistics 'stats' can hold
+     * @return Number of statistics available, possibly more than 'capacity'
+    **/
+    size_t (*stats)(shared_t shared, struct tm_ext_stat* stats, size_t capacity);
+    /** Prepare the calling thread to run transactions on a shared memory region, before its first one.
+    **/
+    void (*thread_init)(shared_t shared);
+    /** Release what the calling thread holds for a shared memory region, after its last transaction.
+    **/
+    void (*thread_fini)(shared_t shared);
+    /** [thread-safe] End a transaction on purpose, without committing it.
+     * @return Whether its writes were discarded, false if the library could only commit them (e.g. already done in place)
+    **/
+    bool (*abort)(shared_t shared, tx_t tx);
+    /** Create a shared memory region whose commits are durable, same contract as 'tm_create' otherwise.
+     * Once the region can no longer persist its commits, 'tm_begin' fails for every read-write transaction.
+     * @param path       Path of the file backing the region, not backing any other open region
+     * @param latency_us Longest wait for concurrent commits to share a sync (in microseconds), 0 for none
+     * @param capacity   Size of the backing file, bounding every segment allocated (in bytes), 0 for the library's default
+     * @param reset      Whether to discard the content of the file, instead of recovering the region it holds
+    **/
+    shared_t (*create_durable)(size_t size, size_t align, char const* path, long latency_us, size_t capacity, bool reset);
+    /** [thread-safe] Add to a 64-bit word without reading it, so that concurrent additions to the same word need not conflict.
+     * Same contract as 'tm_write' otherwise, for regions aligned on 8 bytes only.
+     * @param target Shared word to add to
+     * @param delta  Value to add (wrapping around)
+    **/
+    bool (*add)(shared_t shared, tx_t tx, void* target, int64_t delta);
+};
+
+// -------------------------------------------------------------------------- //
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Get the library's extension table.
+ * @param version 'TM_EXT_VERSION' the caller was built with
+ * @return Extension table (statically allocated), NULL if that version is not supported
+**/
+struct tm_ext const* tm_ext_query(uint32_t version);
+
+#ifdef __cplusplus
+}
+#endif
@@ -1,6 +1,48 @@
 #include "shared-lock.h"
 
+#if SHARED_LOCK_BRAVO
+#include <sched.h>
+#include <time.h>
+
+#include "macros.h"
+
+// Bias revocation cost multiplier, for the time the bias stays revoked
+#ifndef SHARED_LOCK_INHIBIT
+#define SHARED_LOCK_INHIBIT 9
+#endif
+
+static atomic_uintptr_t next_token = 1; // Next thread token to hand out
+static _Thread_local uintptr_t token = 0; // Calling thread's token, 0 until its first shared acquisition
+
+/** Get the current monotonic time, fine-grained enough to time a revocation.
+ * @return Monotonic time (in ns)
+**/
+static uint64_t now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ull + (uint64_t) ts.tv_nsec;
+}
+
+/** Get the calling thread's slot in the given lock, and its token.
+ * @param lock  Lock to get the slot of
+ * @param owner Token of the calling thread to set
+ * @return Calling thread's slot
+**/
+static struct shared_lock_slot_t* own_slot(struct shared_lock_t* lock, uintptr_t* owner) {
+    if (unlikely(token == 0))
+        token = atomic_fetch_add_explicit(&next_token, 1, memory_order_relaxed);
+    *owner = token;
+    return &lock->slots[token % SHARED_LOCK_SLOTS];
+}
+#endif
+
 bool shared_lock_init(struct shared_lock_t* lock) {
+#if SHARED_LOCK_BRAVO
+    atomic_init(&lock->rbias, true);
+    lock->inhibit_until = 0;
+    for (size_t i = 0; i < SHARED_LOCK_SLOTS; ++i)
+        atomic_init(&lock->slots[i].owner, 0);
+#endif
     return pthread_rwlock_init(&lock->rwlock, NULL) == 0;
 }
 
@@ -9,7 +51,21 @@ void shared_lock_cleanup(struct shared_lock_t* lock) {
 }
 
 bool shared_lock_acquire(struct shared_lock_t* lock) {
-    return pthread_rwlock_wrlock(&lock->rwlock) == 0;
+    if (pthread_rwlock_wrlock(&lock->rwlock) != 0)
+        return false;
+#if SHARED_LOCK_BRAVO
+    if (atomic_load_explicit(&lock->rbias, memory_order_relaxed)) { // Revoke the bias, then wait for the visible readers
+        uint64_t start = now();
+        atomic_store(&lock->rbias, false);
+        for (size_t i = 0; i < SHARED_LOCK_SLOTS; ++i) {
+            while (atomic_load(&lock->slots[i].owner) != 0)
+                sched_yield();
+        }
+        uint64_t end = now();
+        lock->inhibit_until = end + SHARED_LOCK_INHIBIT * (end - start);
+    }
+#endif
+    return true;
 }
 
 void shared_lock_release(struct shared_lock_t* lock) {
@@ -17,9 +73,35 @@ void shared_lock_release(struct shared_lock_t* lock) {
 }
 
 bool shared_lock_acquire_shared(struct shared_lock_t* lock) {
-    return pthread_rwlock_rdlock(&lock->rwlock) == 0;
+#if SHARED_LOCK_BRAVO
+    if (atomic_load_explicit(&lock->rbias, memory_order_relaxed)) { // Fast path: publish in the thread's slot
+        uintptr_t owner;
+        struct shared_lock_slot_t* slot = own_slot(lock, &owner);
+        uintptr_t expected = 0;
+        if (atomic_compare_exchange_strong(&slot->owner, &expected, owner)) {
+            if (likely(atomic_load(&lock->rbias))) // Still biased: no writer can have missed the slot
+                return true;
+            atomic_store_explicit(&slot->owner, 0, memory_order_release);
+        }
+    }
+#endif
+    if (pthread_rwlock_rdlock(&lock->rwlock) != 0)
+        return false;
+#if SHARED_LOCK_BRAVO
+    if (!atomic_load_explicit(&lock->rbias, memory_order_relaxed) && now() > lock->inhibit_until)
+        atomic_store(&lock->rbias, true);
+#endif
+    return true;
 }
 
 void shared_lock_release_shared(struct shared_lock_t* lock) {
+#if SHARED_LOCK_BRAVO
+    uintptr_t owner;
+    struct shared_lock_slot_t* slot = own_slot(lock, &owner);
+    if (atomic_load_explicit(&slot->owner, memory_order_relaxed) == owner) { // Taken through the slot
+        atomic_store_explicit(&slot->owner, 0, memory_order_release);
+        return;
+    }
+#endif
     pthread_rwlock_unlock(&lock->rwlock);
 }
@@ -11,12 +11,47 @@
 #include <pthread.h>
 #include <stdbool.h>
 
+/** Whether shared locks use per-thread reader slots in front of the reader-writer lock.
+ * Build with -DSHARED_LOCK_BRAVO=0 for the plain reader-writer lock.
+**/
+#ifndef SHARED_LOCK_BRAVO
+#define SHARED_LOCK_BRAVO 1
+#endif
+
+#if SHARED_LOCK_BRAVO
+#include <stdatomic.h>
+#include <stdint.h>
+
+#define SHARED_LOCK_SLOTS 64 // Reader slots per lock, threads beyond that share them
+#define SHARED_LOCK_LINE  64 // Cache line size (in bytes), each slot being on its own
+
+/**
+ * @brief One visible reader slot, holding the token of the thread that took
+ * the lock through it, 0 if free.
+ */
+struct shared_lock_slot_t {
+    atomic_uintptr_t owner;
+    char padding[SHARED_LOCK_LINE - sizeof(atomic_uintptr_t)];
+};
+#endif
+
 /**
  * @brief A lock that can be taken exclusively but also shared. Contrarily to
  * exclusive locks, shared locks do not have wait/wake_up capabilities.
+ *
+ * With SHARED_LOCK_BRAVO, readers publish themselves in a slot of their own
+ * instead of updating the reader-writer lock word, as long as the lock is
+ * reader-biased (BRAVO). A writer revokes the bias, then waits for the slots
+ * to drain; readers only restore the bias some time after the revocation,
+ * proportional to how long it took, so that writers are not slowed down.
  */
 struct shared_lock_t {
     pthread_rwlock_t rwlock;
+#if SHARED_LOCK_BRAVO
+    atomic_bool rbias;      // Whether readers may take the lock through their slot
+    uint64_t inhibit_until; // Monotonic time (in ns) before which the bias stays revoked (under rwlock)
+    struct shared_lock_slot_t slots[SHARED_LOCK_SLOTS];
+#endif
 };
 
 /** Initialize the given lock.
@@ -0,0 +1,121 @@
+#include <pthread.h>
+#include <inttypes.h>
+#include <assert.h>
+#include <stdio.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include <tm.h>
+#include "tmExt.h"
+
+#define RUNS 4096
+#define THREADS 4
+#define DATA_TEXT_SIZE 1024
+#define BUFFER_SIZE 8
+
+struct data {
+  char text[DATA_TEXT_SIZE];
+};
+
+// Layout of the shared memory region.
+struct shared_state {
+  int64_t produced_until;
+  int64_t consumed_until;
+  struct data buffer[BUFFER_SIZE];
+};
+
+static shared_t shared;
+
+bool are_same(struct data* a, struct data* b) {
+  for (int i = 0; i < DATA_TEXT_SIZE; i++)
+    if (a->text[i] != b->text[i]) return false;
+  return true;
+}
+
+struct data produced[RUNS] = { 0 }; // used to check correctness
+struct data consumed[RUNS] = { 0 }; // used to check correctness
+
+void* produce(void* null) {
+  struct shared_state* state = tm_start(shared);
+  for (int r = 0; r < RUNS; r++) {
+    for (int i = 0; i < DATA_TEXT_SIZE; i++)
+      produced[r].text[i] = rand();
+    while (true) {
+      tx_t tx = tm_begin(shared, false);
+      int64_t consumed_until;
+      if (!tm_read(shared, tx, &state->consumed_until, sizeof(int64_t), &consumed_until))
+        continue;
+      if (consumed_until + BUFFER_SIZE <= r) {
+        // The buffer is full: sleep until the consumer commits, instead of
+        // running the transaction again and again.
+        tm_retry(shared, tx);
+        continue;
+      }
+      int64_t next = r + 1;
+      if (!tm_write(shared, tx, &produced[r], sizeof(struct data), &state->buffer[r % BUFFER_SIZE]))
+        continue;
+      if (!tm_write(shared, tx, &next, sizeof(int64_t), &state->produced_until))
+        continue;
+      if (tm_end(shared, tx)) break;
+    }
+    printf("can produce %d\n", r);
+  }
+  return NULL;
+}
+
+void* consume(void* null) {
+  struct shared_state* state = tm_start(shared);
+  for (int r = 0; r < RUNS; r++) {
+    while (true) {
+      tx_t tx = tm_begin(shared, false);
+      int64_t produced_until;
+      if (!tm_read(shared, tx, &state->produced_until, sizeof(int64_t), &produced_until))
+        continue;
+      if (produced_until <= r) {
+        tm_retry(shared, tx); // Nothing to consume yet: wait for the producer.
+        continue;
+      }
+      int64_t next = r + 1;
+      if (!tm_read_range(shared, tx, &state->buffer[r % BUFFER_SIZE], sizeof(struct data), &consumed[r]))
+        continue;
+      if (!tm_write(shared, tx, &next, sizeof(int64_t), &state->consumed_until))
+        continue;
+      if (tm_end(shared, tx)) break;
+    }
+    printf("can consume %d\n", r);
+  }
+  return NULL;
+}
+
+int main() {
+  shared = tm_create(sizeof(struct shared_state), sizeof(int64_t));
+  assert(shared != invalid_shared);
+  int res;
+  pthread_t producer;
+  res = pthread_create(&producer, NULL, produce, NULL);
+  assert(!res);
+
+  pthread_t consumer;
+  res = pthread_create(&consumer, NULL, consume, NULL);
+  assert(!res);
+
+  res = pthread_join(consumer, NULL);
+  assert(!res);
+
+  res = pthread_join(producer, NULL);
+  assert(!res);
+
+  tm_destroy(shared);
+
+  int r = 0;
+  for (; r < RUNS; r++) {
+    if (!are_same(&produced[r], &consumed[r])) {
+      printf("Consumed the wrong data on round %d.\n", r);
+      break;
+    }
+  }
+  if (r == RUNS) {
+    printf("Looks correct to me! :)\n");
+  }
+}